@@ -1,44 +1,147 @@
 #pragma once
 #include "Node.h"
 #include <vector>
+#include <memory_resource>
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <typeinfo>
+#include <type_traits>
 #include <assert.h>
 
+class FlatBehaviourTree;
+
 class BehaviourTree: public Node
 {
 public:
 	BehaviourTree(): myRootNode(nullptr) {}
-	BehaviourTree(const std::shared_ptr<Node>& aRootNode) : BehaviourTree() { myRootNode = aRootNode; }
+	BehaviourTree(const std::shared_ptr<Node>& aRootNode) : BehaviourTree() { SetRoot(aRootNode); }
+
+	Status Update(TickContext& aContext) override { return myRootNode->Tick(aContext); }
+	void SetRoot(const std::shared_ptr<Node>& aRootNode);
 
-	Status Update() { return myRootNode->Tick(); }
-	void SetRoot(const std::shared_ptr<Node>& aRootNode) { myRootNode = aRootNode; }
+	// Size of the BehaviourTreeState needed to tick this tree, the tree itself included
+	size_t GetNodeCount() const { return myNodeCount; }
 
 private:
 	std::shared_ptr<Node> myRootNode = nullptr;
+	size_t myNodeCount = 1;
 };
 
+// Optional single-block storage for a built tree. Nodes and the child lists of their composites are bump
+// allocated in the order the Builder creates them, which is depth first, and all of it is released at once
+// when the last owner of the arena goes away. Pointers between nodes inside an arena don't own anything,
+// only the tree handed out by the Builder keeps the arena alive.
+class NodeArena: public std::pmr::memory_resource
+{
+public:
+	NodeArena(size_t aBlockSize = 4096): myBlockSize(aBlockSize) {}
+	~NodeArena()
+	{
+		for(auto node = myNodes.rbegin(); node != myNodes.rend(); node++)
+		{
+			(*node)->~Node();
+		}
+		for(char* block : myBlocks)
+		{
+			::operator delete(block);
+		}
+	}
+
+	NodeArena(const NodeArena&) = delete;
+	NodeArena& operator=(const NodeArena&) = delete;
+
+	template <class NodeType, typename... Arguments>
+	NodeType* New(Arguments... someArguments)
+	{
+		void* memory = allocate(sizeof(NodeType), alignof(NodeType));
+
+		std::pmr::memory_resource* previousResource = ourConstructionResource;
+		ourConstructionResource = this;
+		NodeType* node = new(memory) NodeType((someArguments)...);
+		ourConstructionResource = previousResource;
+
+		myNodes.push_back(node);
+		return node;
+	}
+
+	size_t GetUsedBytes() const { return myUsedBytes; }
+
+	// Where composites being constructed put their child list, the arena creating them or the default heap
+	static std::pmr::memory_resource* GetConstructionResource()
+	{
+		return ourConstructionResource != nullptr ? ourConstructionResource : std::pmr::get_default_resource();
+	}
+
+private:
+	void* do_allocate(size_t aByteCount, size_t anAlignment) override
+	{
+		size_t offset = (myOffset + anAlignment - 1) & ~(anAlignment - 1);
+		if(myBlocks.empty() || offset + aByteCount > myCurrentBlockSize)
+		{
+			myCurrentBlockSize = std::max(myBlockSize, aByteCount + anAlignment);
+			myBlocks.push_back(static_cast<char*>(::operator new(myCurrentBlockSize)));
+			offset = 0;
+		}
+
+		myOffset = offset + aByteCount;
+		myUsedBytes += aByteCount;
+		return myBlocks.back() + offset;
+	}
+	void do_deallocate(void* aPointer, size_t aByteCount, size_t anAlignment) override { aPointer; aByteCount; anAlignment; }
+	bool do_is_equal(const std::pmr::memory_resource& anOther) const noexcept override { return this == &anOther; }
+
+	static inline thread_local std::pmr::memory_resource* ourConstructionResource = nullptr;
+
+	std::vector<char*> myBlocks;
+	std::vector<Node*> myNodes;
+	size_t myBlockSize;
+	size_t myCurrentBlockSize = 0;
+	size_t myOffset = 0;
+	size_t myUsedBytes = 0;
+};
+
+// Creates a node in anArena, as a non-owning pointer, or on the heap when there is no arena
+template <class NodeType, typename... Arguments>
+std::shared_ptr<NodeType> MakeNode(NodeArena* anArena, Arguments... someArguments)
+{
+	if(anArena == nullptr)
+		return std::make_shared<NodeType>((someArguments)...);
+
+	return std::shared_ptr<NodeType>(std::shared_ptr<NodeType>(), anArena->New<NodeType>((someArguments)...));
+}
+
 class Composite: public Node
 {
 public:
-	Composite() = default;
+	Composite(): myChildren(NodeArena::GetConstructionResource()) {}
 	virtual ~Composite() {}
 
 	void AddChild(std::shared_ptr<Node> anAddedChild) { myChildren.push_back(anAddedChild); }
+	const std::pmr::vector<std::shared_ptr<Node>>& GetChildren() const { return myChildren; }
+
+	void BindFlatTree(FlatBehaviourTree* aFlatTree) { myFlatTree = aFlatTree; }
 
 protected:
-	std::vector<std::shared_ptr<Node>> myChildren;
-	std::vector<std::shared_ptr<Node>>::iterator myIterator;
+	virtual size_t GetChildCount() const { return myChildren.size(); }
+	virtual Status UpdateChild(TickContext& aContext, size_t anIndex);
+
+	std::pmr::vector<std::shared_ptr<Node>> myChildren;
+
+private:
+	FlatBehaviourTree* myFlatTree = nullptr;
 };
 
 template <class Parent>
 class CompositeBuilder
 {
 public:
-	CompositeBuilder(Parent* aParent, Composite* aComposite): myParent(aParent), myComposite(aComposite) {}
+	CompositeBuilder(Parent* aParent, Composite* aComposite, NodeArena* anArena = nullptr): myParent(aParent), myComposite(aComposite), myArena(anArena) {}
 
 	template <class NodeType, typename... Arguments>
 	CompositeBuilder<Parent> Leaf(Arguments... someArguments)
 	{
-		auto child = std::make_shared<NodeType>((someArguments)...);
+		auto child = MakeNode<NodeType>(myArena, (someArguments)...);
 		myComposite->AddChild(child);
 		return *this;
 	}
@@ -46,9 +149,9 @@ public:
 	template <class CompositeType, typename... Arguments>
 	CompositeBuilder<CompositeBuilder<Parent>> Composites(Arguments... someArguments)
 	{
-		auto child = std::make_shared<CompositeType>((someArguments)...);
+		auto child = MakeNode<CompositeType>(myArena, (someArguments)...);
 		myComposite->AddChild(child);
-		return CompositeBuilder<CompositeBuilder<Parent>>(this, (CompositeType*)child.get());
+		return CompositeBuilder<CompositeBuilder<Parent>>(this, (CompositeType*)child.get(), myArena);
 	}
 
 	Parent& End()
@@ -59,57 +162,73 @@ public:
 private:
 	Parent* myParent;
 	Composite* myComposite;
+	NodeArena* myArena;
 };
 
 class Builder
 {
 public:
+	Builder() = default;
+	// Builds every node of the tree into anArena, see NodeArena
+	Builder(const std::shared_ptr<NodeArena>& anArena): myArena(anArena) {}
+
 	template <class NodeType, typename... Arguments>
 	Builder Leaf(Arguments... someArguments)
 	{
-		myRoot = std::make_shared<NodeType>((someArguments)...);
+		myRoot = MakeNode<NodeType>(myArena.get(), (someArguments)...);
 		return *this;
 	}
 
 	template <class CompositeType, typename... Arguments>
 	CompositeBuilder<Builder> Composites(Arguments... someArguments)
 	{
-		myRoot = std::make_shared<CompositeType>((someArguments)...);
-		return CompositeBuilder<Builder>(this, (CompositeType*)myRoot.get());
+		myRoot = MakeNode<CompositeType>(myArena.get(), (someArguments)...);
+		return CompositeBuilder<Builder>(this, (CompositeType*)myRoot.get(), myArena.get());
 	}
 
 	std::shared_ptr<Node> Build()
 	{
 		assert(myRoot != nullptr && "The Behavior Tree is empty!");
-		auto tree = std::make_shared<BehaviourTree>();
+		auto tree = MakeNode<BehaviourTree>(myArena.get());
 		tree->SetRoot(myRoot);
-		return tree;
+		return Own(tree);
 	}
 
+	std::shared_ptr<FlatBehaviourTree> Compile();
+
 private:
+	// Pointers into the arena don't own anything, the ones handed out share ownership of the whole arena
+	template <class NodeType>
+	std::shared_ptr<NodeType> Own(const std::shared_ptr<NodeType>& aNode) const
+	{
+		return myArena != nullptr ? std::shared_ptr<NodeType>(myArena, aNode.get()) : aNode;
+	}
+
+	std::shared_ptr<NodeArena> myArena;
 	std::shared_ptr<Node> myRoot;
 };
 
 class Sequence: public Composite
 {
 public:
-	void Init() override
+	void Init(TickContext& aContext) override
 	{
-		myIterator = myChildren.begin();
+		aContext.GetCursor(myIndex) = 0;
 	}
-	Status Update()override
+	Status Update(TickContext& aContext)override
 	{
 		assert(!myChildren.empty() && "Composite has no children");
 
-		while(myIterator != myChildren.end())
+		uint16_t& cursor = aContext.GetCursor(myIndex);
+		while(cursor < myChildren.size())
 		{
-			auto status = (*myIterator)->Tick();
+			auto status = myChildren[cursor]->Tick(aContext);
 
 			if(status != Status::Success)
 			{
 				return status;
 			}
-			myIterator++;
+			cursor++;
 		}
 		return Status::Success;
 	}
@@ -119,23 +238,24 @@ private:
 class Selector: public Composite
 {
 public:
-	void Init() override
+	void Init(TickContext& aContext) override
 	{
-		myIterator = myChildren.begin();
+		aContext.GetCursor(myIndex) = 0;
 	}
-	Status Update()override
+	Status Update(TickContext& aContext)override
 	{
 		assert(!myChildren.empty() && "Composite has no children");
 
-		while(myIterator != myChildren.end())
+		uint16_t& cursor = aContext.GetCursor(myIndex);
+		while(cursor < myChildren.size())
 		{
-			auto status = (*myIterator)->Tick();
+			auto status = myChildren[cursor]->Tick(aContext);
 
 			if(status != Status::Failure)
 			{
 				return status;
 			}
-			myIterator++;
+			cursor++;
 		}
 		return Status::Failure;
 	}
@@ -147,7 +267,698 @@ class Leaf: public Node
 public:
 	Leaf() = default;
 	virtual ~Leaf() {}
-	virtual Status Update() = 0;
+	virtual Status Update(TickContext& aContext) = 0;
+private:
+};
+
+// Numbers a subtree depth first starting at aNextIndex, returns the first index after it
+inline uint16_t AssignNodeIndices(Node& aNode, uint16_t aNextIndex)
+{
+	aNode.SetIndex(aNextIndex++);
+
+	if(Composite* composite = dynamic_cast<Composite*>(&aNode))
+	{
+		for(const auto& child : composite->GetChildren())
+		{
+			aNextIndex = AssignNodeIndices(*child, aNextIndex);
+		}
+	}
+	return aNextIndex;
+}
+
+inline void BehaviourTree::SetRoot(const std::shared_ptr<Node>& aRootNode)
+{
+	myRootNode = aRootNode;
+	myNodeCount = AssignNodeIndices(*myRootNode, static_cast<uint16_t>(myIndex + 1));
+}
+
+// Lowered form of a built tree. Nodes are stored breadth first so the children of a node are contiguous,
+// and a node's index in the array is also its slot in the BehaviourTreeState. Plain Sequence/Selector nodes
+// are ticked by the tree itself, every other node keeps its own Update() and reaches its children through
+// Composite::UpdateChild. The tree is immutable once built and can be shared between agents.
+class FlatBehaviourTree
+{
+public:
+	enum class Kind: uint8_t { Sequence, Selector, Custom };
+
+	struct FlatNode
+	{
+		Node* node;
+		uint16_t firstChild;
+		uint16_t childCount;
+		Kind kind;
+	};
+
+	FlatBehaviourTree(const std::shared_ptr<Node>& aRootNode): myRootNode(aRootNode)
+	{
+		assert(myRootNode != nullptr && "The Behavior Tree is empty!");
+
+		myNodes.push_back({ myRootNode.get(), 0, 0, GetKind(*myRootNode) });
+		for(size_t i = 0; i < myNodes.size(); i++)
+		{
+			myNodes[i].node->SetIndex(static_cast<uint16_t>(i));
+
+			Composite* composite = dynamic_cast<Composite*>(myNodes[i].node);
+			if(composite == nullptr)
+				continue;
+
+			composite->BindFlatTree(this);
+			myNodes[i].firstChild = static_cast<uint16_t>(myNodes.size());
+			myNodes[i].childCount = static_cast<uint16_t>(composite->GetChildren().size());
+
+			for(const auto& child : composite->GetChildren())
+			{
+				myNodes.push_back({ child.get(), 0, 0, GetKind(*child) });
+			}
+		}
+	}
+
+	Node::Status Update(TickContext& aContext) const
+	{
+		assert(aContext.GetNodeCount() >= myNodes.size() && "Tree state is too small for this tree");
+		return TickNode(aContext, 0);
+	}
+
+	Node::Status UpdateChild(TickContext& aContext, uint16_t aParentIndex, size_t aChildIndex) const
+	{
+		assert(aChildIndex < myNodes[aParentIndex].childCount && "Child index out of range");
+		return TickNode(aContext, static_cast<uint16_t>(myNodes[aParentIndex].firstChild + aChildIndex));
+	}
+
+	size_t GetNodeCount() const { return myNodes.size(); }
+
 private:
+	static Kind GetKind(const Node& aNode)
+	{
+		if(typeid(aNode) == typeid(Sequence))
+			return Kind::Sequence;
+		if(typeid(aNode) == typeid(Selector))
+			return Kind::Selector;
+		return Kind::Custom;
+	}
+
+	Node::Status TickNode(TickContext& aContext, uint16_t anIndex) const
+	{
+		const FlatNode& flatNode = myNodes[anIndex];
+		Node::Status& status = aContext.GetStatus(anIndex);
+
+		if(status != Node::Status::Running)
+		{
+			if(flatNode.kind == Kind::Custom)
+				flatNode.node->Init(aContext);
+			else
+				aContext.GetCursor(anIndex) = 0;
+		}
+
+		status = UpdateNode(aContext, anIndex);
+
+		if(status != Node::Status::Running)
+		{
+			AbortChildren(aContext, anIndex);
+			if(flatNode.kind == Kind::Custom)
+				flatNode.node->Terminate(aContext, status);
+		}
+
+		return status;
+	}
+
+	// A node that is done can leave running children behind when it stops early, those are terminated as failed
+	void AbortChildren(TickContext& aContext, uint16_t anIndex) const
+	{
+		const FlatNode& flatNode = myNodes[anIndex];
+		for(uint16_t child = flatNode.firstChild; child < flatNode.firstChild + flatNode.childCount; child++)
+		{
+			Node::Status& status = aContext.GetStatus(child);
+			if(status != Node::Status::Running)
+				continue;
+
+			AbortChildren(aContext, child);
+			if(myNodes[child].kind == Kind::Custom)
+				myNodes[child].node->Terminate(aContext, Node::Status::Failure);
+			status = Node::Status::Invalid;
+		}
+	}
+
+	Node::Status UpdateNode(TickContext& aContext, uint16_t anIndex) const
+	{
+#ifdef BEHAVIOUR_TREE_PROFILING
+		BehaviourTreeProfiler::Scope profile(typeid(*myNodes[anIndex].node).name());
+#endif
+		Node::Status status;
+		switch(myNodes[anIndex].kind)
+		{
+		case Kind::Sequence:
+			status = UpdateComposite(aContext, anIndex, Node::Status::Success);
+			break;
+		case Kind::Selector:
+			status = UpdateComposite(aContext, anIndex, Node::Status::Failure);
+			break;
+		default:
+			status = myNodes[anIndex].node->Update(aContext);
+			break;
+		}
+
+#ifdef BEHAVIOUR_TREE_PROFILING
+		profile.SetStatus(static_cast<uint8_t>(status));
+#endif
+		return status;
+	}
+
+	// Sequence continues while children succeed, Selector while they fail
+	Node::Status UpdateComposite(TickContext& aContext, uint16_t anIndex, Node::Status aContinueStatus) const
+	{
+		const FlatNode& flatNode = myNodes[anIndex];
+		assert(flatNode.childCount > 0 && "Composite has no children");
+
+		uint16_t& cursor = aContext.GetCursor(anIndex);
+		while(cursor < flatNode.childCount)
+		{
+			auto status = TickNode(aContext, static_cast<uint16_t>(flatNode.firstChild + cursor));
+
+			if(status != aContinueStatus)
+			{
+				return status;
+			}
+			cursor++;
+		}
+		return aContinueStatus;
+	}
+
+	std::shared_ptr<Node> myRootNode;
+	std::vector<FlatNode> myNodes;
 };
 
+inline Node::Status Composite::UpdateChild(TickContext& aContext, size_t anIndex)
+{
+	if(myFlatTree != nullptr)
+		return myFlatTree->UpdateChild(aContext, myIndex, anIndex);
+
+	return myChildren[anIndex]->Tick(aContext);
+}
+
+inline std::shared_ptr<FlatBehaviourTree> Builder::Compile()
+{
+	assert(myRoot != nullptr && "The Behavior Tree is empty!");
+	return std::make_shared<FlatBehaviourTree>(Own(myRoot));
+}
+
+// Reactive ticking. A node type may declare `static constexpr uint32_t ourReadMask` with the blackboard
+// fields it reads, nodes that don't are treated as reading everything. Static trees collect the masks of
+// the nodes they tick, so a running tree can be skipped until one of those fields changes.
+template <class NodeType, class = void>
+struct StaticReadMask { static constexpr uint32_t value = ~0u; };
+
+template <class NodeType>
+struct StaticReadMask<NodeType, std::void_t<decltype(NodeType::ourReadMask)>> { static constexpr uint32_t value = NodeType::ourReadMask; };
+
+template <class NodeType, class = void>
+struct StaticNodeCount { static constexpr size_t value = 1; };
+
+template <class NodeType>
+struct StaticNodeCount<NodeType, std::void_t<decltype(NodeType::ourNodeCount)>> { static constexpr size_t value = NodeType::ourNodeCount; };
+
+template <class NodeType, class = void>
+struct IsStaticComposite: std::false_type {};
+
+template <class NodeType>
+struct IsStaticComposite<NodeType, std::void_t<decltype(std::declval<NodeType&>().AssignIndices(std::declval<uint16_t&>()))>>: std::true_type {};
+
+template <class NodeType>
+void AssignStaticIndices(NodeType& aNode, uint16_t& aNextIndex)
+{
+	if constexpr(IsStaticComposite<NodeType>::value)
+		aNode.AssignIndices(aNextIndex);
+	else
+		aNode.SetIndex(aNextIndex++);
+}
+
+// Conditional aborts. A node type may declare `static bool Condition(TickContext&)`, the guard it needs to
+// hold to run. Static composites check it before ticking the node and abort the node's running subtree when
+// it fails. A StaticSelector also re-checks the guards of the higher priority children while a lower one is
+// running, and aborts the running child as soon as one of them holds again.
+template <class NodeType, class = void>
+struct HasCondition: std::false_type {};
+
+template <class NodeType>
+struct HasCondition<NodeType, std::void_t<decltype(NodeType::Condition(std::declval<TickContext&>()))>>: std::true_type {};
+
+template <class NodeType, class = void>
+struct HasStaticChildren: std::false_type {};
+
+template <class NodeType>
+struct HasStaticChildren<NodeType, std::void_t<decltype(std::declval<NodeType&>().AbortChildren(std::declval<TickContext&>()))>>: std::true_type {};
+
+// Terminates aNode and its running descendants, deepest first, as failed. Their statuses go back to
+// Invalid so they start over with Init the next time they are ticked.
+template <class NodeType>
+void AbortStatic(NodeType& aNode, TickContext& aContext)
+{
+	Node::Status& status = aContext.GetStatus(aNode.GetIndex());
+	if(status != Node::Status::Running)
+		return;
+
+	if constexpr(HasStaticChildren<NodeType>::value)
+		aNode.AbortChildren(aContext);
+
+	aNode.NodeType::Terminate(aContext, Node::Status::Failure);
+	status = Node::Status::Invalid;
+}
+
+// Aborts aNode if its condition fails, returns whether it may be ticked
+template <class NodeType>
+bool PassesCondition(NodeType& aNode, TickContext& aContext)
+{
+	if constexpr(HasCondition<NodeType>::value)
+	{
+		if(!NodeType::Condition(aContext))
+		{
+			AbortStatic(aNode, aContext);
+			return false;
+		}
+	}
+	aNode; aContext;
+	return true;
+}
+
+// Agents ticked together by a static tree in lockstep, every node runs for all agents that reach it before
+// the tree moves on to the next node. Keep one batch alive between frames so its buffers are reused.
+class TickBatch
+{
+public:
+	template <size_t NodeCount>
+	void Add(BehaviourTreeState<NodeCount>& aState, void* anAgent)
+	{
+		myContexts.emplace_back(aState, anAgent);
+		myReadMasks.push_back(&aState.activeReadMask);
+	}
+	void Clear()
+	{
+		myContexts.clear();
+		myReadMasks.clear();
+	}
+
+	size_t GetCount() const { return myContexts.size(); }
+	Node::Status GetResult(size_t anAgent) const { return myResults[anAgent]; }
+
+	// Used by the static trees while ticking, members are the agent indices reaching the current node
+	void Begin()
+	{
+		myResults.assign(myContexts.size(), Node::Status::Invalid);
+		myMembers.clear();
+		for(uint32_t i = 0; i < myContexts.size(); i++)
+		{
+			myContexts[i].ClearReadMask();
+			myMembers.push_back(i);
+		}
+	}
+	void End()
+	{
+		for(size_t i = 0; i < myContexts.size(); i++)
+		{
+			*myReadMasks[i] = myContexts[i].GetReadMask();
+		}
+	}
+
+	TickContext& GetContext(uint32_t anAgent) { return myContexts[anAgent]; }
+	void SetResult(uint32_t anAgent, Node::Status aStatus) { myResults[anAgent] = aStatus; }
+	std::vector<uint32_t>& GetMembers() { return myMembers; }
+
+private:
+	std::vector<TickContext> myContexts;
+	std::vector<uint32_t*> myReadMasks;
+	std::vector<Node::Status> myResults;
+	std::vector<uint32_t> myMembers;
+};
+
+template <class NodeType, class = void>
+struct HasStaticBatch: std::false_type {};
+
+template <class NodeType>
+struct HasStaticBatch<NodeType, std::void_t<decltype(std::declval<NodeType&>().UpdateBatch(std::declval<TickBatch&>(), size_t(), size_t()))>>: std::true_type {};
+
+// Ticks aNode for the aCount members starting at aFirst. Nodes without a batched update, leaves and custom
+// composites, are ticked for each member in a tight loop.
+template <class NodeType>
+void TickStaticBatch(NodeType& aNode, TickBatch& aBatch, size_t aFirst, size_t aCount)
+{
+	if constexpr(HasStaticBatch<NodeType>::value)
+	{
+		aNode.UpdateBatch(aBatch, aFirst, aCount);
+	}
+	else
+	{
+		for(size_t i = aFirst; i < aFirst + aCount; i++)
+		{
+			uint32_t agent = aBatch.GetMembers()[i];
+			aBatch.SetResult(agent, Node::TickStatic(aNode, aBatch.GetContext(agent)));
+		}
+	}
+}
+
+// While a composite runs its children in a batch its own status slot holds Invalid for the agents that
+// are still pending. Sub-batches are appended to the member list and dropped once the child is done.
+template <Node::Status ContinueStatus, size_t Index = 0, class... Children>
+void TickStaticChildrenBatch(std::tuple<Children...>& someChildren, uint16_t aParentIndex, TickBatch& aBatch, size_t aFirst, size_t aCount)
+{
+	if constexpr(Index < sizeof...(Children))
+	{
+		using ChildType = std::tuple_element_t<Index, std::tuple<Children...>>;
+
+		size_t childFirst = aBatch.GetMembers().size();
+		for(size_t i = aFirst; i < aFirst + aCount; i++)
+		{
+			uint32_t agent = aBatch.GetMembers()[i];
+			TickContext& context = aBatch.GetContext(agent);
+
+			if(context.GetStatus(aParentIndex) == Node::Status::Invalid && context.GetCursor(aParentIndex) == Index)
+			{
+				context.AddReadMask(StaticReadMask<ChildType>::value);
+
+				// A child whose condition fails counts as failed without being ticked
+				if(!PassesCondition(std::get<Index>(someChildren), context))
+				{
+					if(ContinueStatus == Node::Status::Failure)
+						context.GetCursor(aParentIndex)++;
+					else
+						context.GetStatus(aParentIndex) = Node::Status::Failure;
+					continue;
+				}
+				aBatch.GetMembers().push_back(agent);
+			}
+		}
+
+		size_t childCount = aBatch.GetMembers().size() - childFirst;
+		if(childCount > 0)
+		{
+			TickStaticBatch(std::get<Index>(someChildren), aBatch, childFirst, childCount);
+
+			for(size_t i = childFirst; i < childFirst + childCount; i++)
+			{
+				uint32_t agent = aBatch.GetMembers()[i];
+				TickContext& context = aBatch.GetContext(agent);
+				Node::Status status = aBatch.GetResult(agent);
+
+				if(status != ContinueStatus)
+					context.GetStatus(aParentIndex) = status;
+				else
+					context.GetCursor(aParentIndex)++;
+			}
+		}
+		aBatch.GetMembers().resize(childFirst);
+
+		TickStaticChildrenBatch<ContinueStatus, Index + 1>(someChildren, aParentIndex, aBatch, aFirst, aCount);
+	}
+}
+
+template <Node::Status ContinueStatus, class NodeType, class... Children>
+void UpdateStaticCompositeBatch(NodeType& aNode, std::tuple<Children...>& someChildren, TickBatch& aBatch, size_t aFirst, size_t aCount)
+{
+	uint16_t index = aNode.GetIndex();
+
+	for(size_t i = aFirst; i < aFirst + aCount; i++)
+	{
+		TickContext& context = aBatch.GetContext(aBatch.GetMembers()[i]);
+		Node::Status& status = context.GetStatus(index);
+		if(status != Node::Status::Running)
+		{
+			aNode.NodeType::Init(context);
+		}
+		else if constexpr(ContinueStatus == Node::Status::Failure)
+		{
+			aNode.Preempt(context);
+		}
+		status = Node::Status::Invalid;
+	}
+
+	TickStaticChildrenBatch<ContinueStatus>(someChildren, index, aBatch, aFirst, aCount);
+
+	for(size_t i = aFirst; i < aFirst + aCount; i++)
+	{
+		uint32_t agent = aBatch.GetMembers()[i];
+		TickContext& context = aBatch.GetContext(agent);
+		Node::Status& status = context.GetStatus(index);
+		if(status == Node::Status::Invalid)
+		{
+			status = ContinueStatus;
+		}
+
+		aBatch.SetResult(agent, status);
+		if(status != Node::Status::Running)
+		{
+			aNode.NodeType::Terminate(context, status);
+		}
+	}
+}
+
+// Compile-time trees. The layout is described by types and every node is held by value, so a tree is a
+// single object with a known size and ticks resolve to direct calls. Nodes are numbered depth first.
+template <class... Children>
+class StaticSequence: public Node
+{
+	static_assert(sizeof...(Children) > 0, "Composite has no children");
+public:
+	static constexpr uint32_t ourReadMask = 0;
+	static constexpr size_t ourNodeCount = (1 + ... + StaticNodeCount<Children>::value);
+
+	void AssignIndices(uint16_t& aNextIndex)
+	{
+		myIndex = aNextIndex++;
+		std::apply([&aNextIndex](auto&... someChildren) { (AssignStaticIndices(someChildren, aNextIndex), ...); }, myChildren);
+	}
+
+	void Init(TickContext& aContext) override { aContext.GetCursor(myIndex) = 0; }
+	Status Update(TickContext& aContext) override { return UpdateFrom<0>(aContext, aContext.GetCursor(myIndex)); }
+
+	void UpdateBatch(TickBatch& aBatch, size_t aFirst, size_t aCount)
+	{
+		UpdateStaticCompositeBatch<Status::Success>(*this, myChildren, aBatch, aFirst, aCount);
+	}
+
+	void AbortChildren(TickContext& aContext)
+	{
+		std::apply([&aContext](auto&... someChildren) { (AbortStatic(someChildren, aContext), ...); }, myChildren);
+	}
+
+private:
+	template <size_t Index>
+	Status UpdateFrom(TickContext& aContext, uint16_t& aCursor)
+	{
+		if constexpr(Index == sizeof...(Children))
+		{
+			return Status::Success;
+		}
+		else
+		{
+			using ChildType = std::tuple_element_t<Index, std::tuple<Children...>>;
+			if(aCursor == Index)
+			{
+				aContext.AddReadMask(StaticReadMask<ChildType>::value);
+				auto& child = std::get<Index>(myChildren);
+				auto status = PassesCondition(child, aContext) ? Node::TickStatic(child, aContext) : Status::Failure;
+
+				if(status != Status::Success)
+				{
+					return status;
+				}
+				aCursor++;
+			}
+			return UpdateFrom<Index + 1>(aContext, aCursor);
+		}
+	}
+
+	std::tuple<Children...> myChildren;
+};
+
+template <class... Children>
+class StaticSelector: public Node
+{
+	static_assert(sizeof...(Children) > 0, "Composite has no children");
+public:
+	static constexpr uint32_t ourReadMask = 0;
+	static constexpr size_t ourNodeCount = (1 + ... + StaticNodeCount<Children>::value);
+
+	void AssignIndices(uint16_t& aNextIndex)
+	{
+		myIndex = aNextIndex++;
+		std::apply([&aNextIndex](auto&... someChildren) { (AssignStaticIndices(someChildren, aNextIndex), ...); }, myChildren);
+	}
+
+	void Init(TickContext& aContext) override { aContext.GetCursor(myIndex) = 0; }
+	Status Update(TickContext& aContext) override
+	{
+		uint16_t& cursor = aContext.GetCursor(myIndex);
+		if(aContext.GetStatus(myIndex) == Status::Running)
+		{
+			PreemptFrom<0>(aContext, cursor);
+		}
+		return UpdateFrom<0>(aContext, cursor);
+	}
+
+	void UpdateBatch(TickBatch& aBatch, size_t aFirst, size_t aCount)
+	{
+		UpdateStaticCompositeBatch<Status::Failure>(*this, myChildren, aBatch, aFirst, aCount);
+	}
+
+	void AbortChildren(TickContext& aContext)
+	{
+		std::apply([&aContext](auto&... someChildren) { (AbortStatic(someChildren, aContext), ...); }, myChildren);
+	}
+
+	// Called while running, hands control back to a higher priority child whose condition holds again
+	void Preempt(TickContext& aContext) { PreemptFrom<0>(aContext, aContext.GetCursor(myIndex)); }
+
+private:
+	template <size_t Index>
+	void PreemptFrom(TickContext& aContext, uint16_t& aCursor)
+	{
+		if constexpr(Index < sizeof...(Children))
+		{
+			if(Index >= aCursor)
+				return;
+
+			using ChildType = std::tuple_element_t<Index, std::tuple<Children...>>;
+			if constexpr(HasCondition<ChildType>::value)
+			{
+				aContext.AddReadMask(StaticReadMask<ChildType>::value);
+				if(ChildType::Condition(aContext))
+				{
+					AbortChildren(aContext);
+					aCursor = static_cast<uint16_t>(Index);
+					return;
+				}
+			}
+			PreemptFrom<Index + 1>(aContext, aCursor);
+		}
+	}
+
+	template <size_t Index>
+	Status UpdateFrom(TickContext& aContext, uint16_t& aCursor)
+	{
+		if constexpr(Index == sizeof...(Children))
+		{
+			return Status::Failure;
+		}
+		else
+		{
+			using ChildType = std::tuple_element_t<Index, std::tuple<Children...>>;
+			if(aCursor == Index)
+			{
+				aContext.AddReadMask(StaticReadMask<ChildType>::value);
+				auto& child = std::get<Index>(myChildren);
+				auto status = PassesCondition(child, aContext) ? Node::TickStatic(child, aContext) : Status::Failure;
+
+				if(status != Status::Failure)
+				{
+					return status;
+				}
+				aCursor++;
+			}
+			return UpdateFrom<Index + 1>(aContext, aCursor);
+		}
+	}
+
+	std::tuple<Children...> myChildren;
+};
+
+// Gives a custom composite (a Composite subclass with its own Update) a fixed set of children
+template <class CompositeType, class... Children>
+class StaticComposite final: public CompositeType
+{
+public:
+	static constexpr size_t ourNodeCount = (1 + ... + StaticNodeCount<Children>::value);
+
+	void AssignIndices(uint16_t& aNextIndex)
+	{
+		this->myIndex = aNextIndex++;
+		std::apply([&aNextIndex](auto&... someChildren) { (AssignStaticIndices(someChildren, aNextIndex), ...); }, myChildren);
+	}
+
+	void AbortChildren(TickContext& aContext)
+	{
+		std::apply([&aContext](auto&... someChildren) { (AbortStatic(someChildren, aContext), ...); }, myChildren);
+	}
+
+protected:
+	size_t GetChildCount() const override { return sizeof...(Children); }
+	Node::Status UpdateChild(TickContext& aContext, size_t anIndex) override { return UpdateChildAt<0>(aContext, anIndex); }
+
+private:
+	template <size_t Index>
+	Node::Status UpdateChildAt(TickContext& aContext, size_t anIndex)
+	{
+		if constexpr(Index == sizeof...(Children))
+		{
+			assert(false && "Child index out of range");
+			return Node::Status::Invalid;
+		}
+		else
+		{
+			using ChildType = std::tuple_element_t<Index, std::tuple<Children...>>;
+			if(anIndex == Index)
+			{
+				aContext.AddReadMask(StaticReadMask<ChildType>::value);
+				auto& child = std::get<Index>(myChildren);
+				return PassesCondition(child, aContext) ? Node::TickStatic(child, aContext) : Node::Status::Failure;
+			}
+			return UpdateChildAt<Index + 1>(aContext, anIndex);
+		}
+	}
+
+	std::tuple<Children...> myChildren;
+};
+
+// The tree definition, one instance can be shared by every agent using this layout. Each agent keeps its
+// own State, a POD block of ourNodeCount statuses and cursors.
+template <class RootType>
+class StaticBehaviourTree
+{
+public:
+	static constexpr size_t ourNodeCount = StaticNodeCount<RootType>::value;
+	using State = BehaviourTreeState<ourNodeCount>;
+
+	StaticBehaviourTree()
+	{
+		uint16_t nextIndex = 0;
+		AssignStaticIndices(myRootNode, nextIndex);
+	}
+
+	bool NeedsUpdate(const State& aState, uint32_t someChangedFields) const
+	{
+		return aState.statuses[0] != Node::Status::Running || (someChangedFields & aState.activeReadMask) != 0;
+	}
+
+	Node::Status Update(State& aState, void* anAgent)
+	{
+		TickContext context(aState, anAgent);
+		context.AddReadMask(StaticReadMask<RootType>::value);
+
+		auto status = Node::TickStatic(myRootNode, context);
+		aState.activeReadMask = context.GetReadMask();
+		return status;
+	}
+
+	// Skips the tick while the tree is running and none of the fields read on the running path changed
+	Node::Status Update(State& aState, void* anAgent, uint32_t someChangedFields)
+	{
+		if(!NeedsUpdate(aState, someChangedFields))
+			return Node::Status::Running;
+
+		return Update(aState, anAgent);
+	}
+
+	// Ticks every agent in aBatch in lockstep, the results match calling Update for each agent
+	void UpdateBatch(TickBatch& aBatch)
+	{
+		aBatch.Begin();
+		for(uint32_t i = 0; i < aBatch.GetCount(); i++)
+		{
+			aBatch.GetContext(i).AddReadMask(StaticReadMask<RootType>::value);
+		}
+
+		TickStaticBatch(myRootNode, aBatch, 0, aBatch.GetCount());
+		aBatch.End();
+	}
+
+private:
+	RootType myRootNode;
+};
@@ -0,0 +1,271 @@
+#include "BehaviourTreeAsset.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <typeinfo>
+
+namespace
+{
+	constexpr char magic[4] = { 'B', 'T', 'R', 'E' };
+	constexpr size_t headerSize = sizeof(magic) + 4 * sizeof(uint16_t);
+
+	uint16_t ReadUInt16(const uint8_t* aData)
+	{
+		return static_cast<uint16_t>(aData[0] | (aData[1] << 8));
+	}
+
+	void WriteUInt16(std::vector<uint8_t>& aBinary, size_t aValue)
+	{
+		aBinary.push_back(static_cast<uint8_t>(aValue & 0xff));
+		aBinary.push_back(static_cast<uint8_t>((aValue >> 8) & 0xff));
+	}
+}
+
+NodeTypeRegistry::Factory NodeTypeRegistry::Find(std::string_view aName) const
+{
+	for (const Entry& entry : myTypes)
+	{
+		if (entry.name == aName)
+			return entry.factory;
+	}
+	return nullptr;
+}
+
+bool BehaviourTreeAsset::Open(const void* someData, size_t aByteCount)
+{
+	const uint8_t* data = static_cast<const uint8_t*>(someData);
+	if (aByteCount < headerSize || std::memcmp(data, magic, sizeof(magic)) != 0)
+		return false;
+	if (ReadUInt16(data + 4) != ourVersion)
+		return false;
+
+	uint16_t typeCount = ReadUInt16(data + 6);
+	uint16_t nodeCount = ReadUInt16(data + 8);
+	uint16_t stringBytes = ReadUInt16(data + 10);
+
+	size_t typesOffset = headerSize;
+	size_t nodesOffset = typesOffset + typeCount * sizeof(TypeEntry);
+	size_t stringsOffset = nodesOffset + nodeCount * sizeof(NodeRecord);
+	if (nodeCount == 0 || stringsOffset + stringBytes > aByteCount)
+		return false;
+
+	const TypeEntry* types = reinterpret_cast<const TypeEntry*>(data + typesOffset);
+	const NodeRecord* nodes = reinterpret_cast<const NodeRecord*>(data + nodesOffset);
+
+	for (uint16_t i = 0; i < typeCount; i++)
+	{
+		if (types[i].nameOffset + types[i].nameLength > stringBytes)
+			return false;
+	}
+
+	// Every node but the root is the child of an earlier one, so the child counts have to add up exactly
+	size_t openChildren = 1;
+	for (uint16_t i = 0; i < nodeCount; i++)
+	{
+		if (nodes[i].type >= typeCount || openChildren == 0)
+			return false;
+		openChildren += nodes[i].childCount - 1;
+	}
+	if (openChildren != 0)
+		return false;
+
+	myTypes = types;
+	myNodes = nodes;
+	myStrings = reinterpret_cast<const char*>(data + stringsOffset);
+	myTypeCount = typeCount;
+	myNodeCount = nodeCount;
+	return true;
+}
+
+std::shared_ptr<FlatBehaviourTree> BehaviourTreeAsset::Instantiate(const NodeTypeRegistry& aRegistry, std::string& anError) const
+{
+	assert(myNodes != nullptr && "Asset is not open");
+
+	std::vector<NodeTypeRegistry::Factory> factories;
+	for (uint16_t i = 0; i < myTypeCount; i++)
+	{
+		std::string_view name(myStrings + myTypes[i].nameOffset, myTypes[i].nameLength);
+		factories.push_back(aRegistry.Find(name));
+		if (factories.back() == nullptr)
+		{
+			anError = "Unregistered node type " + std::string(name);
+			return nullptr;
+		}
+	}
+
+	struct OpenComposite
+	{
+		Composite* composite;
+		uint16_t remainingChildren;
+	};
+
+	auto arena = std::make_shared<NodeArena>(myNodeCount * 64);
+	std::vector<OpenComposite> openComposites;
+	Node* root = nullptr;
+
+	for (uint16_t i = 0; i < myNodeCount; i++)
+	{
+		Node* node = factories[myNodes[i].type](*arena);
+
+		if (openComposites.empty())
+			root = node;
+		else
+		{
+			openComposites.back().composite->AddChild(std::shared_ptr<Node>(std::shared_ptr<Node>(), node));
+			if (--openComposites.back().remainingChildren == 0)
+				openComposites.pop_back();
+		}
+
+		if (myNodes[i].childCount > 0)
+		{
+			Composite* composite = dynamic_cast<Composite*>(node);
+			if (composite == nullptr)
+			{
+				anError = std::string("Children given to ") + typeid(*node).name() + ", which is not a Composite";
+				return nullptr;
+			}
+			openComposites.push_back({ composite, myNodes[i].childCount });
+		}
+	}
+
+	return std::make_shared<FlatBehaviourTree>(std::shared_ptr<Node>(arena, root));
+}
+
+bool BehaviourTreeAsset::Compile(std::string_view aSource, std::vector<uint8_t>& aBinary, std::string& anError)
+{
+	std::vector<std::string_view> typeNames;
+	std::vector<NodeRecord> nodes;
+	std::vector<size_t> indents;	// Indent of every node on the path from the root to the last node
+	std::vector<size_t> parents;
+
+	size_t lineNumber = 0;
+	size_t lineStart = 0;
+	while (lineStart <= aSource.size())
+	{
+		size_t lineEnd = aSource.find('\n', lineStart);
+		if (lineEnd == std::string_view::npos)
+			lineEnd = aSource.size();
+
+		std::string_view line = aSource.substr(lineStart, lineEnd - lineStart);
+		lineStart = lineEnd + 1;
+		lineNumber++;
+
+		size_t indent = line.find_first_not_of(" \t\r");
+		if (indent == std::string_view::npos || line[indent] == '#')
+			continue;
+
+		size_t nameEnd = line.find_first_of(" \t\r#", indent);
+		std::string_view name = line.substr(indent, nameEnd == std::string_view::npos ? std::string_view::npos : nameEnd - indent);
+
+		while (!indents.empty() && indents.back() >= indent)
+		{
+			indents.pop_back();
+			parents.pop_back();
+		}
+		if (indents.empty() && !nodes.empty())
+		{
+			anError = "Line " + std::to_string(lineNumber) + ": a tree has a single root";
+			return false;
+		}
+
+		auto type = std::find(typeNames.begin(), typeNames.end(), name);
+		if (type == typeNames.end())
+			type = typeNames.insert(typeNames.end(), name);
+
+		if (!parents.empty())
+			nodes[parents.back()].childCount++;
+
+		indents.push_back(indent);
+		parents.push_back(nodes.size());
+		nodes.push_back({ static_cast<uint16_t>(type - typeNames.begin()), 0 });
+	}
+
+	if (nodes.empty())
+	{
+		anError = "The tree is empty";
+		return false;
+	}
+
+	std::string strings;
+	aBinary.assign(std::begin(magic), std::end(magic));
+	WriteUInt16(aBinary, ourVersion);
+	WriteUInt16(aBinary, typeNames.size());
+	WriteUInt16(aBinary, nodes.size());
+
+	for (std::string_view name : typeNames)
+		strings += name;
+	WriteUInt16(aBinary, strings.size());
+
+	size_t nameOffset = 0;
+	for (std::string_view name : typeNames)
+	{
+		WriteUInt16(aBinary, nameOffset);
+		WriteUInt16(aBinary, name.size());
+		nameOffset += name.size();
+	}
+	for (const NodeRecord& node : nodes)
+	{
+		WriteUInt16(aBinary, node.type);
+		WriteUInt16(aBinary, node.childCount);
+	}
+	aBinary.insert(aBinary.end(), strings.begin(), strings.end());
+	return true;
+}
+
+BehaviourTreeResource::BehaviourTreeResource(const NodeTypeRegistry& aRegistry, const std::filesystem::path& aPath, size_t aMaxNodeCount, std::string& anError):
+	myRegistry(aRegistry), myPath(aPath), myMaxNodeCount(aMaxNodeCount)
+{
+	Reload(anError);
+}
+
+bool BehaviourTreeResource::Reload(std::string& anError)
+{
+	std::error_code error;
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(myPath, error);
+	if (error)
+	{
+		anError = myPath.string() + ": " + error.message();
+		return false;
+	}
+	if (myTree != nullptr && writeTime == myWriteTime)
+		return false;
+
+	myWriteTime = writeTime;
+
+	std::ifstream file(myPath, std::ios::binary);
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (bytes.size() < sizeof(magic) || std::memcmp(bytes.data(), magic, sizeof(magic)) != 0)
+	{
+		std::string source(bytes.begin(), bytes.end());
+		if (!BehaviourTreeAsset::Compile(source, bytes, anError))
+		{
+			anError = myPath.string() + ": " + anError;
+			return false;
+		}
+	}
+
+	BehaviourTreeAsset asset;
+	if (!asset.Open(bytes.data(), bytes.size()))
+	{
+		anError = myPath.string() + ": not a valid behaviour tree asset";
+		return false;
+	}
+	if (asset.GetNodeCount() > myMaxNodeCount)
+	{
+		anError = myPath.string() + ": " + std::to_string(asset.GetNodeCount()) + " nodes, the tree state holds " + std::to_string(myMaxNodeCount);
+		return false;
+	}
+
+	std::shared_ptr<FlatBehaviourTree> tree = asset.Instantiate(myRegistry, anError);
+	if (tree == nullptr)
+	{
+		anError = myPath.string() + ": " + anError;
+		return false;
+	}
+
+	myTree = tree;
+	myGeneration++;
+	return true;
+}
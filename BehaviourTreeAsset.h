@@ -0,0 +1,107 @@
+#pragma once
+#include "BehaviourTree.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Maps the node type names used in tree assets to the types that implement them
+class NodeTypeRegistry
+{
+public:
+	using Factory = Node* (*)(NodeArena& anArena);
+
+	template <class NodeType>
+	void Register(std::string_view aName)
+	{
+		myTypes.push_back({ std::string(aName), [](NodeArena& anArena) -> Node* { return anArena.New<NodeType>(); } });
+	}
+
+	Factory Find(std::string_view aName) const;
+
+private:
+	struct Entry
+	{
+		std::string name;
+		Factory factory;
+	};
+
+	std::vector<Entry> myTypes;
+};
+
+// Read-only view of a binary tree asset, the bytes can come straight from a memory mapped file. Layout, all
+// fields little endian uint16 after the magic:
+//   header     "BTRE", version, type count, node count, string bytes
+//   types      name offset and length into the string table, per type
+//   nodes      type index and child count, per node in depth first order
+//   strings    type names, not null terminated
+class BehaviourTreeAsset
+{
+public:
+	static constexpr uint16_t ourVersion = 1;
+
+	// Checks the header and every offset up front, the asset is not usable if this returns false
+	bool Open(const void* someData, size_t aByteCount);
+
+	// Builds the tree into a single NodeArena. Type names are resolved once per type, not per node.
+	// Returns nullptr and sets anError if the asset uses a type missing from aRegistry.
+	std::shared_ptr<FlatBehaviourTree> Instantiate(const NodeTypeRegistry& aRegistry, std::string& anError) const;
+
+	size_t GetNodeCount() const { return myNodeCount; }
+
+	// Compiles the text form into the binary form. One node per line, children indented one step deeper
+	// than their parent, blank lines and lines starting with # are skipped:
+	//   Selector
+	//       HaveNoOrder
+	//           Intro
+	static bool Compile(std::string_view aSource, std::vector<uint8_t>& aBinary, std::string& anError);
+
+private:
+	struct TypeEntry
+	{
+		uint16_t nameOffset;
+		uint16_t nameLength;
+	};
+
+	struct NodeRecord
+	{
+		uint16_t type;
+		uint16_t childCount;
+	};
+
+	const TypeEntry* myTypes = nullptr;
+	const NodeRecord* myNodes = nullptr;
+	const char* myStrings = nullptr;
+	uint16_t myTypeCount = 0;
+	uint16_t myNodeCount = 0;
+};
+
+// A tree asset on disk that can be swapped while the game runs. The file may hold either form, text is
+// compiled when loaded. Agents ticking the tree compare GetGeneration() with the one they started on and
+// reset their BehaviourTreeState when it changed, the old tree stays alive until they let go of it.
+class BehaviourTreeResource
+{
+public:
+	// Loads the file right away, anError is set if that fails. aMaxNodeCount is the size of the
+	// BehaviourTreeState the agents tick with, larger trees are rejected when loaded.
+	BehaviourTreeResource(const NodeTypeRegistry& aRegistry, const std::filesystem::path& aPath, size_t aMaxNodeCount, std::string& anError);
+
+	// Reloads the file if it was written since the last load, returns true when the tree was replaced.
+	// A file that fails to load keeps the previous tree and sets anError.
+	bool Reload(std::string& anError);
+
+	const std::shared_ptr<FlatBehaviourTree>& GetTree() const { return myTree; }
+	uint32_t GetGeneration() const { return myGeneration; }
+	size_t GetMaxNodeCount() const { return myMaxNodeCount; }
+
+private:
+	const NodeTypeRegistry& myRegistry;
+	std::filesystem::path myPath;
+	size_t myMaxNodeCount;
+	std::filesystem::file_time_type myWriteTime;
+	std::shared_ptr<FlatBehaviourTree> myTree;
+	uint32_t myGeneration = 0;
+};
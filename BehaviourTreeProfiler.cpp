@@ -0,0 +1,114 @@
+#include "BehaviourTreeProfiler.h"
+
+#include <algorithm>
+
+namespace
+{
+	BehaviourTreeProfiler::Event events[BehaviourTreeProfiler::ourCapacity];
+	std::atomic<uint64_t> nextEvent = 0;
+	std::atomic<uint32_t> nextThread = 0;
+
+	thread_local BehaviourTreeProfiler::Scope* currentScope = nullptr;
+	thread_local uint32_t threadIndex = nextThread++;
+
+	const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+	const char* statusNames[] = { "Invalid", "Success", "Failure", "Running" };
+
+	// Oldest to newest, at most ourCapacity events
+	template <class Function>
+	void ForEachEvent(Function aFunction)
+	{
+		uint64_t last = nextEvent.load(std::memory_order_acquire);
+		uint64_t first = last > BehaviourTreeProfiler::ourCapacity ? last - BehaviourTreeProfiler::ourCapacity : 0;
+		for (uint64_t i = first; i < last; i++)
+			aFunction(events[i % BehaviourTreeProfiler::ourCapacity]);
+	}
+
+	void WriteName(std::ostream& aStream, const char* aName)
+	{
+		aStream << '"';
+		for (const char* c = aName; *c; c++)
+		{
+			if (*c == '"' || *c == '\\')
+				aStream << '\\';
+			aStream << *c;
+		}
+		aStream << '"';
+	}
+}
+
+uint64_t BehaviourTreeProfiler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void BehaviourTreeProfiler::Record(const Event& anEvent)
+{
+	uint64_t index = nextEvent.fetch_add(1, std::memory_order_relaxed);
+	events[index % ourCapacity] = anEvent;
+}
+
+std::vector<BehaviourTreeProfiler::NodeStats> BehaviourTreeProfiler::GetNodeStats()
+{
+	std::vector<NodeStats> stats;
+	ForEachEvent([&stats](const Event& anEvent)
+		{
+			auto it = std::find_if(stats.begin(), stats.end(), [&anEvent](const NodeStats& aStats) { return aStats.name == anEvent.name; });
+			if (it == stats.end())
+			{
+				stats.push_back({ anEvent.name });
+				it = stats.end() - 1;
+			}
+
+			it->tickCount++;
+			it->inclusiveTime += anEvent.duration;
+			it->exclusiveTime += anEvent.duration - anEvent.childDuration;
+			it->statusCounts[anEvent.status & 3]++;
+		});
+
+	std::sort(stats.begin(), stats.end(), [](const NodeStats& aFirst, const NodeStats& aSecond)
+		{
+			return aFirst.exclusiveTime > aSecond.exclusiveTime;
+		});
+	return stats;
+}
+
+void BehaviourTreeProfiler::WriteChromeTrace(std::ostream& aStream)
+{
+	aStream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+	bool first = true;
+	ForEachEvent([&aStream, &first](const Event& anEvent)
+		{
+			aStream << (first ? "\n" : ",\n") << "{\"name\":";
+			WriteName(aStream, anEvent.name);
+			aStream << ",\"cat\":\"BehaviourTree\",\"ph\":\"X\",\"pid\":0,\"tid\":" << anEvent.thread
+				<< ",\"ts\":" << anEvent.start / 1000.0 << ",\"dur\":" << anEvent.duration / 1000.0
+				<< ",\"args\":{\"status\":\"" << statusNames[anEvent.status & 3]
+				<< "\",\"exclusive_us\":" << (anEvent.duration - anEvent.childDuration) / 1000.0 << "}}";
+			first = false;
+		});
+
+	aStream << "\n]}\n";
+}
+
+void BehaviourTreeProfiler::Clear()
+{
+	nextEvent.store(0, std::memory_order_release);
+}
+
+BehaviourTreeProfiler::Scope::Scope(const char* aName): myName(aName), myParent(currentScope), myStart(Now())
+{
+	currentScope = this;
+}
+
+BehaviourTreeProfiler::Scope::~Scope()
+{
+	uint64_t duration = Now() - myStart;
+	currentScope = myParent;
+	if (myParent)
+		myParent->myChildDuration += duration;
+
+	Record({ myName, myStart, duration, myChildDuration, threadIndex, myStatus });
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Per-node tick profiling, compiled into Node::Tick and Node::TickStatic only when BEHAVIOUR_TREE_PROFILING
+// is defined. Every tick is written to a fixed size ring that overwrites its oldest events, so it can be left
+// running. Writers only share an atomic cursor; read the results between frames, not while trees are ticking.
+namespace BehaviourTreeProfiler
+{
+	struct Event
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t duration;
+		uint64_t childDuration;
+		uint32_t thread;
+		uint8_t status;
+	};
+
+	struct NodeStats
+	{
+		const char* name = nullptr;
+		uint64_t tickCount = 0;
+		uint64_t inclusiveTime = 0;
+		uint64_t exclusiveTime = 0;
+		uint64_t statusCounts[4] = {};	// Indexed by Node::Status
+	};
+
+	constexpr size_t ourCapacity = 1 << 16;
+
+	uint64_t Now();
+	void Record(const Event& anEvent);
+
+	// Times in nanoseconds, summed over the events still in the ring, most expensive exclusive time first
+	std::vector<NodeStats> GetNodeStats();
+
+	// Writes the events still in the ring as Chrome trace_event JSON, for chrome://tracing or Perfetto
+	void WriteChromeTrace(std::ostream& aStream);
+	void Clear();
+
+	// Times one tick. Time spent in child scopes on the same thread is subtracted for the exclusive time.
+	class Scope
+	{
+	public:
+		Scope(const char* aName);
+		~Scope();
+
+		void SetStatus(uint8_t aStatus) { myStatus = aStatus; }
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		const char* myName;
+		Scope* myParent;
+		uint64_t myStart;
+		uint64_t myChildDuration = 0;
+		uint8_t myStatus = 0;
+	};
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+// Equality used by Blackboard::Set to skip writes that change nothing, specialise it for types without operator==
+template <class Type>
+struct BlackboardEqual
+{
+	static bool Equal(const Type& aFirst, const Type& aSecond) { return aFirst == aSecond; }
+};
+
+// Typed store for the values a behaviour tree reads. A key is a type naming its value type as `Type` and the
+// field bit it belongs to as `static constexpr uint32_t ourField`, the same bits reactive trees use as read masks.
+// Values live in place and are read by reference. Every write that changes a value bumps the key's version
+// and flags its field, so writers can set everything each frame and readers only see what actually changed.
+template <class... Keys>
+class Blackboard
+{
+public:
+	template <class Key>
+	const typename Key::Type& Get() const { return std::get<Index<Key>()>(myValues); }
+
+	// Bumped on every change, readers caching something derived from a value can compare against it
+	template <class Key>
+	uint32_t GetVersion() const { return myVersions[Index<Key>()]; }
+
+	// Stores aValue unless it equals the current value, returns whether it changed
+	template <class Key>
+	bool Set(const typename Key::Type& aValue)
+	{
+		typename Key::Type& value = std::get<Index<Key>()>(myValues);
+		if (BlackboardEqual<typename Key::Type>::Equal(value, aValue))
+			return false;
+
+		value = aValue;
+		Touch<Key>();
+		return true;
+	}
+
+	// For writing a value in place, always counts as a change
+	template <class Key>
+	typename Key::Type& Edit()
+	{
+		Touch<Key>();
+		return std::get<Index<Key>()>(myValues);
+	}
+
+	// Fields changed since the previous call, everything before the first one
+	uint32_t TakeChangedFields()
+	{
+		uint32_t changedFields = myChangedFields;
+		myChangedFields = 0;
+		return changedFields;
+	}
+
+private:
+	template <class Key>
+	static constexpr size_t Index()
+	{
+		constexpr bool matches[] = { std::is_same_v<Key, Keys>... };
+		size_t index = 0;
+		while (index < sizeof...(Keys) && !matches[index])
+			index++;
+		return index;
+	}
+
+	template <class Key>
+	void Touch()
+	{
+		static_assert(Index<Key>() < sizeof...(Keys), "Key is not on this blackboard");
+		myVersions[Index<Key>()]++;
+		myChangedFields |= Key::ourField;
+	}
+
+	std::tuple<typename Keys::Type...> myValues = {};
+	uint32_t myVersions[sizeof...(Keys)] = {};
+	uint32_t myChangedFields = ~0u;
+};
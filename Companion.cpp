@@ -4,17 +4,22 @@
 #include "FlyingEnemy.h"
 #include "GroundEnemy.h"
 #include "MainSingleton.h"
+#include "CompanionWorld.h"
+#include "CompanionSteeringBatch.h"
+#include "CompanionAllocations.h"
+#include "CompanionTargetGrid.h"
 #include "EnemyPool.h"
 #include "RigidBodyComponent.h"
 #include "DreamEngine/graphics/PointLight.h" 
 #include <DreamEngine/windows/settings.h>
 #include <DreamEngine/graphics/TextureManager.h>
 #include <DreamEngine/graphics/ModelDrawer.h>
-#include <PhysX\PxPhysicsAPI.h> 
+#include <PhysX/PxPhysicsAPI.h> 
+
+#include <type_traits>
 
 Companion::Companion()
 {
-	myRotation = 0.f;
 	myFoundEnemy = false;
 
 	// fixing collision
@@ -53,10 +58,11 @@ Companion::~Companion()
 void Companion::Init()
 {
 	myBehavior.Init(myModelInstance);
-	myContext.closesHealingStation = CalculateClosesHealingStation();
+	myBehavior.blackboard.Set<CompanionKey::HealingStation>(CalculateClosesHealingStation());
 
 	mySteeringBehavior = new CompanionSteeringBehavior;
 	mySteeringBehavior->Init(myTransform); 
+	myRenderedTransform = myTransform;
 
 	MainSingleton::GetInstance()->GetPostMaster().Subscribe(eMessageType::CompanionFetch, this);
 	MainSingleton::GetInstance()->GetPostMaster().Subscribe(eMessageType::CompanionTurret, this);
@@ -71,21 +77,121 @@ void Companion::Init()
 
 void Companion::Update(float aDeltaTime)
 {
-	if (MainSingleton::GetInstance()->GetGameToPause())
+	if (myGroup != nullptr || CompanionWorld::Get().IsPaused())
 		return;
 	
+	// Acting plays the frame back into the engine, whose allocations aren't the companion's to avoid
+	{
+		CompanionAllocations::FrameCheck allocationCheck(myUpdateCount++);
+		Sense();
+		myBehavior.UpdateTree();
+		Think(aDeltaTime);
+		Steer(aDeltaTime);
+	}
+	Act();
+}
+
+static_assert(std::is_trivially_copyable_v<Companion::Snapshot>, "Companion snapshots are copied with memcpy");
+
+void Companion::Save(Snapshot& aSnapshot) const
+{
+	myBehavior.Save(aSnapshot.behavior);
+	mySteeringBehavior->Save(aSnapshot.steering);
+
+	aSnapshot.position = myTransform.GetPosition();
+	aSnapshot.orientation = myOrientation;
+	aSnapshot.targetRotation = myTargetRotation;
+	aSnapshot.target = myTarget;
+	aSnapshot.steeringForce = mySteeringForce;
+}
+
+void Companion::Restore(const Snapshot& aSnapshot)
+{
+	myBehavior.Restore(aSnapshot.behavior);
+	mySteeringBehavior->Restore(aSnapshot.steering);
+
+	myOrientation = aSnapshot.orientation;
+	myTargetRotation = aSnapshot.targetRotation;
+	myTarget = aSnapshot.target;
+	mySteeringForce = aSnapshot.steeringForce;
+
+	myTransform.SetPosition(aSnapshot.position);
+	myTransform.SetRotation(myOrientation.GetEulerAnglesDegrees());
+	myRenderedTransform = myTransform;
+	myInterpolationStart = myTransform;
+	myRenderedOrientation = myOrientation;
+	myInterpolationStartOrientation = myOrientation;
+	myModelInstance->SetTransform(myTransform);
+
+	physx::PxRigidDynamic* body = static_cast<physx::PxRigidDynamic*>(GetComponent<RigidBodyComponent>()->GetBody());
+	physx::PxTransform currentPose = body->getGlobalPose();
+	body->setGlobalPose(physx::PxTransform(physx::PxVec3(aSnapshot.position.x, aSnapshot.position.y, aSnapshot.position.z), currentPose.q));
+	body->setLinearVelocity(physx::PxVec3(mySteeringForce.x, mySteeringForce.y, mySteeringForce.z));
+}
+
+void Companion::Sense()
+{
 	PrepareBehaviorContext();
-	
-	DreamEngine::Vector3f target = myBehavior.Update(aDeltaTime);
-	DreamEngine::Vector3f steeringForce = SetSteering(aDeltaTime, target);
-	
-	UpdateRotation(aDeltaTime, steeringForce);
-	UpdatePhysics(steeringForce);
+}
+
+void Companion::Think(float aDeltaTime)
+{
+	myTarget = myBehavior.UpdateState(aDeltaTime);
+}
+
+void Companion::QueueProbes(CompanionRaycastBatch& aBatch)
+{
+	// Steering is given the position alone, the probes have to start from the same transform
+	mySteeringBehavior->QueueProbes(myTransform.GetPosition(), aBatch);
+}
+
+void Companion::Steer(float aDeltaTime)
+{
+	mySteeringForce = SetSteering(aDeltaTime, myTarget);
+	mySteeringBehavior->ClearProbes();
+	UpdateRotation(aDeltaTime, mySteeringForce);
+}
+
+void Companion::BeginSteer(float aDeltaTime, CompanionSteeringBatch& aBatch, size_t anIndex)
+{
+	DreamEngine::Vector3f steeringTarget;
+	if (GetSteeringTarget(myTarget, steeringTarget))
+		mySteeringBehavior->BeginUpdate(aDeltaTime, myTransform.GetPosition(), steeringTarget, aBatch, anIndex);
+	else
+		aBatch.SetInactive(anIndex);
+	mySteeringBehavior->ClearProbes();
+}
+
+void Companion::EndSteer(float aDeltaTime, const CompanionSteeringBatch& aBatch, size_t anIndex)
+{
+	mySteeringForce = mySteeringBehavior->EndUpdate(aBatch, anIndex);
+	UpdateRotation(aDeltaTime, mySteeringForce);
+}
+
+void Companion::Act()
+{
+	myBehavior.FlushCommands();
+	UpdatePhysics(mySteeringForce);
 
-	myModelInstance->SetTransform(*GetTransform());
+	myInterpolationStart = myRenderedTransform;
+	myInterpolationStartOrientation = myRenderedOrientation;
+	myRenderedTransform = *GetTransform();
+	myRenderedOrientation = myOrientation;
+	myModelInstance->SetTransform(myRenderedTransform);
 
 	UpdatePointLight();
-	
+}
+
+void Companion::Interpolate(float anAlpha)
+{
+	const DreamEngine::Transform& target = *GetTransform();
+	DE::Vector3f position = myInterpolationStart.GetPosition();
+	myRenderedOrientation = CompanionOrientation::Nlerp(myInterpolationStartOrientation, myOrientation, anAlpha);
+
+	myRenderedTransform = target;
+	myRenderedTransform.SetPosition(position + (target.GetPosition() - position) * anAlpha);
+	myRenderedTransform.SetRotation(myRenderedOrientation.GetEulerAnglesDegrees());
+	myModelInstance->SetTransform(myRenderedTransform);
 }
 
 void Companion::Render(DE::GraphicsEngine & aGraphicsEngine)
@@ -101,32 +207,38 @@ void Companion::RenderVFX(DreamEngine::GraphicsStateStack& aGraphicsStateStack)
 
 void Companion::Receive(const Message & aMessage)
 {
+	// Orders are acted on right away, the tree aborts whatever was running and starts the new branch this frame
 	if(aMessage.messageType == eMessageType::CompanionFetch)
 	{
 		if (myBehavior.GetOrder() != CompanionBehavior::Orders::FollowPlayer) { return; }
 		myBehavior.SetOrder(CompanionBehavior::Orders::Fetch);
+		myBehavior.UpdateTree();
 	}
 	else if(aMessage.messageType == eMessageType::CompanionTurret)
 	{
 		if (myBehavior.GetOrder() != CompanionBehavior::Orders::FollowPlayer) { return; }
 		myBehavior.SetOrder(CompanionBehavior::Orders::Turret);
+		myBehavior.UpdateTree();
 	}
 	else if(aMessage.messageType == eMessageType::CompanionStartIntro)
 	{
 		myBehavior.context.hasWokenUp = true;
+		myBehavior.MarkChanged(CompanionField::HasWokenUp);
 	}
 	else if (aMessage.messageType == eMessageType::PlayerRespawned)
 	{
 		GetTransform()->SetPosition(myPlayer->GetTransform()->GetPosition()); 
-		myModelInstance->SetTransform(*GetTransform()); 
+		myRenderedTransform = *GetTransform();
+		myRenderedOrientation = myOrientation;
+		myModelInstance->SetTransform(myRenderedTransform); 
 		
 		physx::PxRigidDynamic* body = static_cast<physx::PxRigidDynamic*>(GetComponent<RigidBodyComponent>()->GetBody());
 		physx::PxTransform currentPose = body->getGlobalPose();
 		physx::PxTransform updatedPose(physx::PxVec3(myTransform.GetPosition().x, myTransform.GetPosition().y, myTransform.GetPosition().z), currentPose.q);
 		body->setGlobalPose(updatedPose);
 
-		MainSingleton::GetInstance()->GetAudioManager().StopAudio(eAudioEvent::CompanionRevive);
-		MainSingleton::GetInstance()->GetAudioManager().PlayAudio(eAudioEvent::CompanionRevive, myTransform.GetPosition());
+		CompanionWorld::Get().StopAudio(eAudioEvent::CompanionRevive);
+		CompanionWorld::Get().PlayAudio(eAudioEvent::CompanionRevive, myTransform.GetPosition());
 	}
 }
 
@@ -146,15 +258,15 @@ void Companion::SetPointLight(std::shared_ptr<DE::PointLight> aPointLightAbove,
 	myPointLightInside = aPointLightInside;
 }
 
-void Companion::SetTargetedEnemyPos(std::vector<std::shared_ptr<FlyingEnemy>> aEnemyFlyingPos, std::vector<std::shared_ptr<GroundEnemy>> aEnemyGroundPos)
+void Companion::SetTargetedEnemyPos(const std::vector<std::shared_ptr<FlyingEnemy>>& aEnemyFlyingPos, const std::vector<std::shared_ptr<GroundEnemy>>& aEnemyGroundPos)
 {
-	if(!myBehavior.context.shootTimer.ReachedThreshold())
+	if(!myBehavior.IsTimerDone(myBehavior.context.shootTimer))
 		return;
 
 	float dist = 0;
 	int index = 0;
 	DreamEngine::Transform transform;
-	myContext.seesEnemy = false;
+	bool seesEnemy = false;
 
 	for(int i = 0; i < aEnemyFlyingPos.size(); i++)
 	{
@@ -165,7 +277,7 @@ void Companion::SetTargetedEnemyPos(std::vector<std::shared_ptr<FlyingEnemy>> aE
 			dist = (GetTransform()->GetPosition() - enemyTransform.GetPosition()).Length();
 			index = i;
 			transform = enemyTransform;
-			myContext.seesEnemy = true;
+			seesEnemy = true;
 		}
 	}
 	for(int i = 0; i < aEnemyGroundPos.size(); i++)
@@ -177,19 +289,34 @@ void Companion::SetTargetedEnemyPos(std::vector<std::shared_ptr<FlyingEnemy>> aE
 			dist = (GetTransform()->GetPosition() - enemyTransform.GetPosition()).Length();
 			index = i;
 			transform = enemyTransform;
-			myContext.seesEnemy = true;
+			seesEnemy = true;
 		}
 	}
 
 	if(dist > myBehavior.context.shootingLength)
 	{
-		myContext.seesEnemy = false;
+		myBehavior.blackboard.Set<CompanionKey::SeesEnemy>(false);
 		return;
 	}
 
+	myBehavior.blackboard.Set<CompanionKey::SeesEnemy>(seesEnemy);
 	myTargetEnemyTransform = transform;
 }
 
+void Companion::SetTargetedEnemy(const CompanionTargetGrid& aGrid)
+{
+	if(!myBehavior.IsTimerDone(myBehavior.context.shootTimer))
+		return;
+
+	// Nothing in range stops the companion seeing an enemy, as SetTargetedEnemyPos does
+	const CompanionTargetGrid::Target* target = aGrid.FindNearest(GetTransform()->GetPosition(), myBehavior.context.shootingLength);
+	myBehavior.blackboard.Set<CompanionKey::SeesEnemy>(target != nullptr);
+	if(target == nullptr)
+		return;
+
+	myTargetEnemyTransform = *target->transform;
+}
+
 void Companion::AddHealingStationPos(DreamEngine::Vector3f aHealingStationPos)
 {
 	myHealingStationPos.push_back(aHealingStationPos); 
@@ -205,7 +332,7 @@ DreamEngine::Vector3f Companion::CalculateClosesHealingStation()
 
 	for(int i = 0; i < myHealingStationPos.size(); i++)
 	{
-		float dist = (myHealingStationPos[i], GetTransform()->GetPosition()).Length();
+		float dist = (myHealingStationPos[i] - GetTransform()->GetPosition()).Length();
 		if(shortesDist == 0 || shortesDist > dist)
 		{
 			shortesDist = dist;
@@ -230,48 +357,56 @@ void Companion::PrepareBehaviorContext()
 {
 	myModelInstance = myBehavior.context.modelInstance;
 
-	myContext.transform = *GetTransform();
-	myContext.playerPos = myPlayer->GetTransform()->GetPosition();
-	myContext.closesHealingStation = CalculateClosesHealingStation();
-	myContext.enemyPosition = myTargetEnemyTransform.GetPosition();
-	myContext.enemyTransform = &myTargetEnemyTransform;
-
-	myBehavior.SetContext(myContext);
+	// Only values that differ are written, and only those wake up the branches reading them
+	CompanionBlackboard& blackboard = myBehavior.blackboard;
+	blackboard.Set<CompanionKey::Transform>(*GetTransform());
+	blackboard.Set<CompanionKey::PlayerPos>(myPlayer->GetTransform()->GetPosition());
+	blackboard.Set<CompanionKey::HealingStation>(CalculateClosesHealingStation());
+	blackboard.Set<CompanionKey::EnemyPosition>(myTargetEnemyTransform.GetPosition());
+	blackboard.Set<CompanionKey::EnemyTransform>(&myTargetEnemyTransform);
 }
 
 DreamEngine::Vector3f Companion::SetSteering(float aDeltaTime, const DreamEngine::Vector3f& target)
+{
+	DreamEngine::Vector3f steeringTarget;
+	if (!GetSteeringTarget(target, steeringTarget))
+		return DreamEngine::Vector3f(0.0f);
+
+	return mySteeringBehavior->Update(aDeltaTime, myTransform.GetPosition(), steeringTarget);
+}
+
+bool Companion::GetSteeringTarget(const DreamEngine::Vector3f& target, DreamEngine::Vector3f& aSteeringTarget)
 {
 	switch (myBehavior.GetOrder())
 	{
 	case CompanionBehavior::Orders::Fetch:
 	case CompanionBehavior::Orders::Turret:
-		return mySteeringBehavior->Update(aDeltaTime, myTransform.GetPosition(), target);
+		aSteeringTarget = target;
+		return true;
 
 	case CompanionBehavior::Orders::FollowPlayer:
-		return SetFollowPlayerSteering(aDeltaTime, target);
+		aSteeringTarget = GetFollowPlayerTarget(target);
+		return true;
 
 	case CompanionBehavior::Orders::Intro:
-		return myBehavior.context.hasWokenUp
-			? mySteeringBehavior->Update(aDeltaTime, myTransform.GetPosition(), target)
-			: DreamEngine::Vector3f(0.0f);
+		aSteeringTarget = target;
+		return myBehavior.context.hasWokenUp;
 
 	default:
-		return DreamEngine::Vector3f(0.0f);
+		return false;
 	}
 }
 
-DreamEngine::Vector3f Companion::SetFollowPlayerSteering(float aDeltaTime, const DreamEngine::Vector3f& target)
+DreamEngine::Vector3f Companion::GetFollowPlayerTarget(const DreamEngine::Vector3f& target)
 {
 	if (Near(myTransform.GetPosition(), target, 1000.f))
 	{
 		mySteeringBehavior->ChoseClosesBilateral(myPlayer->GetTransform()->GetPosition());
 
-		auto offsetPos = myPlayer->GetTransform()->GetPosition() +
+		return myPlayer->GetTransform()->GetPosition() +
 			mySteeringBehavior->SetOffsetToPlayer(myPlayer->GetTransform()->GetPosition());
-
-		return mySteeringBehavior->Update(aDeltaTime, myTransform.GetPosition(), offsetPos);
 	}
-	return mySteeringBehavior->Update(aDeltaTime, myTransform.GetPosition(), target);
+	return target;
 }
 
 void Companion::UpdatePointLight()
@@ -311,28 +446,28 @@ void Companion::UpdateRotation(float aDeltaTime, const DreamEngine::Vector3f& st
 	else
 		HandleMovingRotation();
 
-	myModelInstance->SetRotation(myRotation);
-	myTransform.SetRotation(myRotation);
+	// The engine takes Euler angles. The model is only given them from Act and Interpolate, on the main thread.
+	myTransform.SetRotation(myOrientation.GetEulerAnglesDegrees());
 }
 
 void Companion::HandleStationaryRotation(float aDeltaTime)
 {
-	myTargetRotation = myBehavior.context.seesEnemy
+	myTargetRotation = myBehavior.blackboard.Get<CompanionKey::SeesEnemy>()
 		? myTargetEnemyTransform.GetPosition() - GetTransform()->GetPosition()
 		: myPlayer->GetTransform()->GetPosition() - GetTransform()->GetPosition();
 
-	myRotation = mySteeringBehavior->RotateToThisOverTime(myTargetRotation, aDeltaTime, 5.f, myRotation);
+	myOrientation = mySteeringBehavior->RotateToThisOverTime(myTargetRotation, aDeltaTime, 5.f, myOrientation);
 }
 
 void Companion::HandleMovingRotation()
 {
-	if (myBehavior.context.seesEnemy)
+	if (myBehavior.blackboard.Get<CompanionKey::SeesEnemy>())
 	{
 		myTargetRotation = myTargetEnemyTransform.GetPosition() - GetTransform()->GetPosition();
-		myRotation = mySteeringBehavior->RotateToThis(myTargetRotation);
+		myOrientation = mySteeringBehavior->RotateToThis(myTargetRotation);
 	}
 	else
-		myRotation = mySteeringBehavior->RotateToVelocity();
+		myOrientation = mySteeringBehavior->RotateToVelocity();
 }
 
 void Companion::UpdatePhysics(const DreamEngine::Vector3f& steeringForce)
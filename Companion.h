@@ -15,16 +15,59 @@ class Player;
 class EnemyPool;
 class GroundEnemy;
 class FlyingEnemy;
+class CompanionGroup;
+class CompanionRaycastBatch;
+class CompanionSteeringBatch;
+class CompanionTargetGrid;
 
 class Companion: public GameObject, public Observer
 {
 public:
+	// Full AI state of one companion as plain data, a level's worth can be kept in one array and copied
+	// with memcpy. Restoring puts the companion and its physics body back where it was.
+	struct Snapshot
+	{
+		CompanionBehavior::Snapshot behavior;
+		CompanionSteeringBehavior::Snapshot steering;
+
+		DreamEngine::Vector3f position;
+		CompanionOrientation orientation;
+		DreamEngine::Vector3f targetRotation;
+		DreamEngine::Vector3f target;
+		DreamEngine::Vector3f steeringForce;
+	};
+
 	Companion();
 	~Companion();
 
 	void Init();
 
 	void Update(float aDeltaTime) override;
+
+	void Save(Snapshot& aSnapshot) const;
+	void Restore(const Snapshot& aSnapshot);
+
+	// Update phases, run in this order. Sense and Steer only touch this companion and may run on worker
+	// threads, the tree tick, Think and Act use engine systems and stay on the main thread.
+	void Sense();
+	void Think(float aDeltaTime);
+	void Steer(float aDeltaTime);
+	void Act();
+
+	// Adds the raycasts the next Steer needs to aBatch, which must be submitted before Steer runs
+	void QueueProbes(CompanionRaycastBatch& aBatch);
+	// Steer split around a CompanionSteeringBatch, for steering many companions together. BeginSteer fills
+	// slot anIndex of aBatch, EndSteer runs once aBatch is updated.
+	void BeginSteer(float aDeltaTime, CompanionSteeringBatch& aBatch, size_t anIndex);
+	void EndSteer(float aDeltaTime, const CompanionSteeringBatch& aBatch, size_t anIndex);
+
+	// Places the model anAlpha of the way from where it was drawn at the last Act to the companion's
+	// current transform, for companions that are not updated every frame
+	void Interpolate(float anAlpha);
+
+	// A companion in a group is updated by CompanionGroup::Update instead of its own Update
+	void SetGroup(CompanionGroup* aGroup) { myGroup = aGroup; }
+	CompanionBehavior& GetBehavior() { return myBehavior; }
 	
 	void Render(DE::GraphicsEngine& aGraphicsEngine) override;
 	void RenderVFX(DreamEngine::GraphicsStateStack& aGraphicsStateStack);
@@ -35,7 +78,9 @@ public:
 	void SetPlayer(std::shared_ptr<Player> aPlayer);
 	void SetModelInstance(std::shared_ptr<DreamEngine::ModelInstance>& aModelInstance);
 	void SetPointLight(std::shared_ptr<DE::PointLight> aPointLightAbove, std::shared_ptr<DE::PointLight> aPointLightInside);
-	void SetTargetedEnemyPos(std::vector<std::shared_ptr<FlyingEnemy>> aEnemyFlyingPos, std::vector<std::shared_ptr<GroundEnemy>> aEnemyGroundPos);
+	void SetTargetedEnemyPos(const std::vector<std::shared_ptr<FlyingEnemy>>& aEnemyFlyingPos, const std::vector<std::shared_ptr<GroundEnemy>>& aEnemyGroundPos);
+	// The same as SetTargetedEnemyPos, looking only at the enemies aGrid has within shooting range
+	void SetTargetedEnemy(const CompanionTargetGrid& aGrid);
 
 	void AddHealingStationPos(DreamEngine::Vector3f aHealingStationPos);
 	DreamEngine::Vector3f CalculateClosesHealingStation(); 
@@ -44,7 +89,9 @@ public:
 	void PrepareBehaviorContext();
 
 	DreamEngine::Vector3f SetSteering(float aDeltaTime, const DreamEngine::Vector3f& target);
-	DreamEngine::Vector3f SetFollowPlayerSteering(float aDeltaTime, const DreamEngine::Vector3f& target); 
+	// Where the companion steers towards for its order, false when it shouldn't move at all
+	bool GetSteeringTarget(const DreamEngine::Vector3f& target, DreamEngine::Vector3f& aSteeringTarget);
+	DreamEngine::Vector3f GetFollowPlayerTarget(const DreamEngine::Vector3f& target); 
 
 	void UpdatePointLight();
 	void UpdateRotation(float aDeltaTime, const DreamEngine::Vector3f& steeringForce);
@@ -61,9 +108,20 @@ private:
 	std::shared_ptr<DreamEngine::PointLight> myPointLightInside;
 	std::vector<DreamEngine::Vector3f> myHealingStationPos;
 
-	CompanionContext myContext;
+	CompanionGroup* myGroup = nullptr;
+	// Updates run on its own, the allocation check starts after a warm-up
+	unsigned int myUpdateCount = 0;
+
+	DreamEngine::Vector3f myTarget;
+	DreamEngine::Vector3f mySteeringForce;
+
+	// Rotations are blended as orientations, the transforms get Euler angles made from them
+	DreamEngine::Transform myRenderedTransform;
+	DreamEngine::Transform myInterpolationStart;
+	CompanionOrientation myRenderedOrientation;
+	CompanionOrientation myInterpolationStartOrientation;
 
-	DreamEngine::Vector3f myRotation;
+	CompanionOrientation myOrientation;
 	DreamEngine::Vector3f myTargetRotation;
 	DreamEngine::Transform myTargetEnemyTransform;
 	bool myFoundEnemy;
@@ -0,0 +1,72 @@
+#include "CompanionAllocations.h"
+
+#include <assert.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+#ifdef COMPANION_COUNT_ALLOCATIONS
+	std::atomic<size_t> allocationCount = 0;
+#endif
+	std::atomic<CompanionAllocations::FrameHook> frameHook = nullptr;
+}
+
+#ifdef COMPANION_COUNT_ALLOCATIONS
+void* operator new(size_t aSize)
+{
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* memory = std::malloc(aSize == 0 ? 1 : aSize))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* aMemory) noexcept
+{
+	std::free(aMemory);
+}
+
+void operator delete(void* aMemory, size_t) noexcept
+{
+	std::free(aMemory);
+}
+#endif
+
+bool CompanionAllocations::IsCounting()
+{
+#ifdef COMPANION_COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+size_t CompanionAllocations::GetCount()
+{
+#ifdef COMPANION_COUNT_ALLOCATIONS
+	return allocationCount.load(std::memory_order_relaxed);
+#else
+	return 0;
+#endif
+}
+
+void CompanionAllocations::SetFrameHook(FrameHook aHook)
+{
+	frameHook = aHook;
+}
+
+CompanionAllocations::FrameCheck::FrameCheck(unsigned int aFrame): myStartCount(GetCount()), myIsChecked(IsCounting() && aFrame >= warmUpFrames)
+{}
+
+CompanionAllocations::FrameCheck::~FrameCheck()
+{
+	if (!myIsChecked)
+		return;
+
+	size_t allocations = GetCount() - myStartCount;
+	if (FrameHook hook = frameHook.load())
+		hook(allocations);
+	else
+		assert(allocations == 0 && "The companion frame allocated after its warm-up");
+}
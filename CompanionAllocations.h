@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+
+// Counts heap allocations to keep the companion frame free of them. Builds with COMPANION_COUNT_ALLOCATIONS
+// defined replace the global operator new and count every allocation made on any thread, so the numbers
+// only mean something where the companions are all that runs, such as the benchmark or a headless world.
+// Other builds count nothing.
+namespace CompanionAllocations
+{
+	// Updates a companion or group gets to grow its containers to their working size before a frame has
+	// to run without allocating
+	constexpr unsigned int warmUpFrames = 8;
+
+	// Called at the end of every checked frame past the warm-up with the allocations it made
+	using FrameHook = void(*)(size_t anAllocationCount);
+
+	bool IsCounting();
+	size_t GetCount();
+
+	// With no hook set, a checked frame that allocates fails an assert
+	void SetFrameHook(FrameHook aHook);
+
+	// Spans the part of a frame that must not allocate, from construction to destruction. aFrame is the
+	// number of frames updated before this one, the check only starts after the warm-up.
+	class FrameCheck
+	{
+	public:
+		explicit FrameCheck(unsigned int aFrame);
+		~FrameCheck();
+
+		FrameCheck(const FrameCheck&) = delete;
+		FrameCheck& operator=(const FrameCheck&) = delete;
+
+	private:
+		size_t myStartCount;
+		bool myIsChecked;
+	};
+}
@@ -1,15 +1,13 @@
 #include "CompanionBehavoiur.h"
 #include "Node.h"
 #include "ProjectilePool.h"
+#include "CompanionWorld.h"
+#include "MainSingleton.h"
 
 #include <iostream>
 #include <algorithm>
 
-#include <DreamEngine/windows/settings.h>
-#include <DreamEngine/graphics/TextureManager.h>
 #include <DreamEngine/graphics/ModelDrawer.h>
-#include <DreamEngine/graphics/ModelFactory.h>
-#include <DreamEngine/windows/settings.h>
 
 namespace
 {
@@ -24,125 +22,259 @@ namespace
 	constexpr float introHeightOffset = 130.0f;
 	constexpr float introCompletionDistance = 25.0f;
 	constexpr float healtPackOffset = 30.0f;
+
+	CompanionTreeDefinition& GetCompanionTree()
+	{
+		static CompanionTreeDefinition tree;
+		return tree;
+	}
 }
 
 CompanionBehavior::CompanionBehavior()
 {
-	myBehaviourTree = std::make_shared<BehaviourTree>(
-		Builder()
-		.Composites<Selector>()
-		.Composites<HaveNoOrder>(this)
-		.Leaf<Intro>(this)
-		.Composites<FollowPlayer>(this)
-		.Leaf<ShootEnemy>(this)
-		.End()						//Close FollowPlayer
-		.End()						//Close HaveNoOrder
-
-		.Composites<HaveOrder>(this)
-		.Composites<Fetch>(this)
-		.Composites<PickUp>(this)
-		.End()						//Close pickup
-		.Composites<DropOff>(this)
-		.End()						//Close Drop off
-		.End()						//Close fetch
-
-		.Composites<Turret>(this)
-		.Leaf<ShootEnemy>(this)
-		.End()						//Close turret
-
-		.End()						//Close have order
-		.End()						//Close root
-		.Build()
-	);
+	context.turretTimer = myOwnTimers.Create(turretDuration, &OnTimerExpired, this, CompanionField::TurretTimer);
+	context.turretCooldown = myOwnTimers.Create(turretCooldown, &OnTimerExpired, this, CompanionField::TurretCooldown);
+	context.shootTimer = myOwnTimers.Create(shootCooldown, &OnTimerExpired, this, CompanionField::ShootTimer);
+	context.healCooldown = myOwnTimers.Create(HealCooldown, &OnTimerExpired, this, CompanionField::HealCooldown);
+	context.conversationTimer = myOwnTimers.Create(conversationInterval, &OnTimerExpired, this, 0);
 }
 
 CompanionBehavior::~CompanionBehavior()
-{}
+{
+	for (TimerHandle* timer : { &context.turretTimer, &context.shootTimer, &context.turretCooldown, &context.healCooldown, &context.conversationTimer })
+		GetTimers().Destroy(*timer);
+}
 
 void CompanionBehavior::Init(std::shared_ptr<DreamEngine::ModelInstance> aModel)
 {
-	myBehaviourTree->Init();
+	myTreeState = {};
 	InitAudio();
 
 	context.modelInstance = aModel;
-
-	context.turretTimer.SetThresholdValue(turretDuration);
-	context.turretCooldown.SetThresholdValue(turretCooldown);
-	context.shootTimer.SetThresholdValue(shootCooldown);
-	context.healCooldown.SetThresholdValue(HealCooldown);
-	context.conversationTimer.SetThresholdValue(conversationInterval);
+	InitTextures();
+	myTextureOrder = Orders::Intro;
 
 	context.hasPickedUp = false;
 	context.noShooting = false;
 
-	context.modelInstanceHealthPack = std::make_shared<DreamEngine::ModelInstance>(
-		DreamEngine::ModelFactory::GetInstance().GetModelInstance(L"3D/SM_P_Healthpack.fbx"));
-
-	context.projectilePool = new ProjectilePool(1, false);
+	context.modelInstanceHealthPack = CompanionWorld::Get().LoadModelInstance(L"3D/SM_P_Healthpack.fbx");
+	context.projectilePool = CompanionWorld::Get().CreateProjectilePool();
 
 	bool activationMessageData = false;
-	MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ &activationMessageData, eMessageType::CompanionHealthCooldownToggle });
-	MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ &activationMessageData, eMessageType::CompanionTurretCooldownToggle });
+	CompanionWorld::Get().TriggerMessage({ &activationMessageData, eMessageType::CompanionHealthCooldownToggle });
+	CompanionWorld::Get().TriggerMessage({ &activationMessageData, eMessageType::CompanionTurretCooldownToggle });
 }
 
 DreamEngine::Vector3f CompanionBehavior::Update(float aDeltaTime)
 {
-	myBehaviourTree->Update();
+	UpdateTree();
+	return UpdateState(aDeltaTime);
+}
 
-	context.turretTimer.Update(aDeltaTime);
-	context.turretCooldown.Update(aDeltaTime);
-	context.shootTimer.Update(aDeltaTime);
-	context.healCooldown.Update(aDeltaTime);
-	context.conversationTimer.Update(aDeltaTime);
+// Everything after the tree tick: timers, projectiles, textures and the cooldown messages
+DreamEngine::Vector3f CompanionBehavior::UpdateState(float aDeltaTime)
+{
+	// A shared wheel is advanced by its owner
+	if (myTimers == nullptr)
+		myOwnTimers.Advance(aDeltaTime);
 
 	if (context.projectilePool)
 		context.projectilePool->Update(aDeltaTime);
 
 	SetTexture();
 
-	if (MainSingleton::GetInstance()->GetInputManager().IsKeyDown(DreamEngine::eKeyCode::H))
+	if (CompanionWorld::Get().IsKeyDown(DreamEngine::eKeyCode::H))
+	{
 		context.noShooting = !context.noShooting;
+		MarkChanged(CompanionField::NoShooting);
+	}
 
-	if (context.turretCooldown.ReachedThreshold() && !context.hasSentCoolDownMSG)
+	if (IsTimerDone(context.turretCooldown) && !context.hasSentCoolDownMSG)
 	{
-		bool activationMessageData = true;
-		MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ &activationMessageData, eMessageType::CompanionTurretCooldownToggle });
+		GetCommands().TriggerMessage(eMessageType::CompanionTurretCooldownToggle, true);
 
 		context.hasSentCoolDownMSG = true;
 	}
-	if (context.healCooldown.ReachedThreshold() && context.hasHealingCoolDown)
+	if (IsTimerDone(context.healCooldown) && context.hasHealingCoolDown)
 	{
-		bool activationMessageData = true;
-		MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ &activationMessageData, eMessageType::CompanionHealthCooldownToggle });
+		GetCommands().TriggerMessage(eMessageType::CompanionHealthCooldownToggle, true);
 
 		context.hasHealingCoolDown = false;
 	}
-	if (context.conversationTimer.ReachedThreshold())
+	if (IsTimerDone(context.conversationTimer))
 	{
 		PlayRandomSound();
-		context.conversationTimer.Reset();
+		RestartTimer(context.conversationTimer);
 	}
 
 	return context.targetPosition;
 }
 
+void CompanionBehavior::UpdateTree()
+{
+	if (myTreeResource == nullptr)
+	{
+		GetCompanionTree().Update(myTreeState, this, TakeChangedFields());
+		return;
+	}
+
+	TakeChangedFields();
+
+	// Hot reloaded, the statuses and cursors of the old tree mean nothing to the new one
+	if (myAssetGeneration != myTreeResource->GetGeneration())
+	{
+		myAssetTree = myTreeResource->GetTree();
+		myAssetGeneration = myTreeResource->GetGeneration();
+		myAssetTreeState = {};
+	}
+
+	if (myAssetTree == nullptr)
+		return;
+
+	TickContext tickContext(myAssetTreeState, this);
+	myAssetTree->Update(tickContext);
+}
+
+void CompanionBehavior::Save(Snapshot& aSnapshot) const
+{
+	aSnapshot.treeState = myTreeState;
+	aSnapshot.assetTreeState = myAssetTreeState;
+	aSnapshot.assetGeneration = myAssetGeneration;
+
+	const TimerWheel& timers = GetTimers();
+	aSnapshot.turretTimer = timers.GetRemaining(context.turretTimer);
+	aSnapshot.shootTimer = timers.GetRemaining(context.shootTimer);
+	aSnapshot.turretCooldown = timers.GetRemaining(context.turretCooldown);
+	aSnapshot.healCooldown = timers.GetRemaining(context.healCooldown);
+	aSnapshot.conversationTimer = timers.GetRemaining(context.conversationTimer);
+
+	aSnapshot.targetPosition = context.targetPosition;
+	aSnapshot.turretPosition = context.turretPosition;
+	aSnapshot.introPosition = context.introPosition;
+
+	aSnapshot.order = myOrder;
+
+	aSnapshot.hasPickedUp = context.hasPickedUp;
+	aSnapshot.noShooting = context.noShooting;
+	aSnapshot.hasSentCoolDownMSG = context.hasSentCoolDownMSG;
+	aSnapshot.hasHealingCoolDown = context.hasHealingCoolDown;
+	aSnapshot.hasWokenUp = context.hasWokenUp;
+	aSnapshot.everyOtherHealing = context.everyOtherHealing;
+}
+
+void CompanionBehavior::Restore(const Snapshot& aSnapshot)
+{
+	myTreeState = aSnapshot.treeState;
+
+	// A tree reloaded since the snapshot can't use its statuses, it starts over instead
+	if (myAssetGeneration == aSnapshot.assetGeneration)
+		myAssetTreeState = aSnapshot.assetTreeState;
+	else
+		myAssetTreeState = {};
+
+	TimerWheel& timers = GetTimers();
+	timers.Start(context.turretTimer, aSnapshot.turretTimer);
+	timers.Start(context.shootTimer, aSnapshot.shootTimer);
+	timers.Start(context.turretCooldown, aSnapshot.turretCooldown);
+	timers.Start(context.healCooldown, aSnapshot.healCooldown);
+	timers.Start(context.conversationTimer, aSnapshot.conversationTimer);
+
+	context.targetPosition = aSnapshot.targetPosition;
+	context.turretPosition = aSnapshot.turretPosition;
+	context.introPosition = aSnapshot.introPosition;
+
+	myOrder = aSnapshot.order;
+
+	context.hasPickedUp = aSnapshot.hasPickedUp;
+	context.noShooting = aSnapshot.noShooting;
+	context.hasSentCoolDownMSG = aSnapshot.hasSentCoolDownMSG;
+	context.hasHealingCoolDown = aSnapshot.hasHealingCoolDown;
+	context.hasWokenUp = aSnapshot.hasWokenUp;
+	context.everyOtherHealing = aSnapshot.everyOtherHealing;
+
+	MarkChanged(CompanionField::All);
+}
+
+void CompanionBehavior::SetTreeResource(const std::shared_ptr<BehaviourTreeResource>& aResource)
+{
+	assert((aResource == nullptr || aResource->GetMaxNodeCount() <= ourMaxAssetNodeCount) && "Resource allows trees larger than the asset tree state");
+	myTreeResource = aResource;
+	myAssetTree = nullptr;
+	myAssetGeneration = 0;
+	myTreeState = {};
+	MarkChanged(CompanionField::All);
+}
+
+void CompanionBehavior::UpdateTrees(const std::vector<CompanionBehavior*>& someBehaviors, TickBatch& aBatch)
+{
+	CompanionTreeDefinition& tree = GetCompanionTree();
+
+	aBatch.Clear();
+	for (CompanionBehavior* behavior : someBehaviors)
+	{
+		if (behavior->myTreeResource != nullptr)
+		{
+			behavior->UpdateTree();
+			continue;
+		}
+
+		if (tree.NeedsUpdate(behavior->myTreeState, behavior->TakeChangedFields()))
+			aBatch.Add(behavior->myTreeState, behavior);
+	}
+	tree.UpdateBatch(aBatch);
+}
+
+void RegisterCompanionNodes(NodeTypeRegistry& aRegistry)
+{
+	aRegistry.Register<Sequence>("Sequence");
+	aRegistry.Register<Selector>("Selector");
+	aRegistry.Register<HaveNoOrder>("HaveNoOrder");
+	aRegistry.Register<HaveOrder>("HaveOrder");
+	aRegistry.Register<FollowPlayer>("FollowPlayer");
+	aRegistry.Register<Fetch>("Fetch");
+	aRegistry.Register<Turret>("Turret");
+	aRegistry.Register<PickUp>("PickUp");
+	aRegistry.Register<DropOff>("DropOff");
+	aRegistry.Register<ShootEnemy>("ShootEnemy");
+	aRegistry.Register<Intro>("Intro");
+}
+
 void CompanionBehavior::Render(DE::GraphicsEngine& aGraphicsEngine)
 {
-	if (context.hasPickedUp)
+	if (context.hasPickedUp && context.modelInstanceHealthPack)
 		aGraphicsEngine.GetModelDrawer().DrawGBCalc(*context.modelInstanceHealthPack.get());
 
 	if (context.projectilePool)
 		context.projectilePool->Render(aGraphicsEngine);
 }
 
-void CompanionBehavior::SetContext(const CompanionContext& someStateToRead)
+uint32_t CompanionBehavior::TakeChangedFields()
+{
+	uint32_t changedFields = myChangedFields | blackboard.TakeChangedFields();
+	myChangedFields = 0;
+	return changedFields;
+}
+
+void CompanionBehavior::SetTimerWheel(TimerWheel* aWheel)
+{
+	TimerWheel& from = GetTimers();
+	myTimers = aWheel;
+	TimerWheel& to = GetTimers();
+
+	for (TimerHandle* timer : { &context.turretTimer, &context.shootTimer, &context.turretCooldown, &context.healCooldown, &context.conversationTimer })
+		from.MoveTo(*timer, to);
+}
+
+void CompanionBehavior::RestartTimer(TimerHandle aTimer)
+{
+	TimerWheel& timers = GetTimers();
+	timers.Restart(aTimer);
+	MarkChanged(timers.GetUserData(aTimer));
+}
+
+void CompanionBehavior::OnTimerExpired(void* aBehavior, uint32_t someFields)
 {
-	context.transform = someStateToRead.transform;
-	context.playerPos = someStateToRead.playerPos;
-	context.closesHealingStation = someStateToRead.closesHealingStation;
-	context.enemyPosition = someStateToRead.enemyPosition;
-	context.enemyTransform = someStateToRead.enemyTransform;
-	context.seesEnemy = someStateToRead.seesEnemy;
+	static_cast<CompanionBehavior*>(aBehavior)->MarkChanged(someFields);
 }
 
 void CompanionBehavior::InitAudio()
@@ -177,87 +309,66 @@ void CompanionBehavior::PlayRandomSound()
 {
 	int soundNr = GetRandomInt(0, (int)myAudios.size() - 1);
 
-	MainSingleton::GetInstance()->GetAudioManager().StopAudio(myAudios[soundNr]);
-	MainSingleton::GetInstance()->GetAudioManager().PlayAudio(myAudios[soundNr], context.transform.GetPosition());
+	GetCommands().PlayAudio(myAudios[soundNr], blackboard.Get<CompanionKey::Transform>().GetPosition());
+}
+
+void CompanionBehavior::InitTextures()
+{
+	Texture(Orders::Fetch, L"3D/T_CH_CompanionHappy_c.dds", L"3D/T_CH_CompanionHappy_n.dds",
+		L"3D/T_CH_CompanionHappy_m.dds", L"3D/T_CH_CompanionHappy_fx.dds");
+	Texture(Orders::FollowPlayer, L"3D/T_CH_Companion_c.dds", L"3D/T_CH_Companion_n.dds",
+		L"3D/T_CH_Companion_m.dds", L"3D/T_CH_Companion_fx.dds");
+	Texture(Orders::Turret, L"3D/T_CH_CompanionAngry_c.dds", L"3D/T_CH_CompanionAngry_n.dds",
+		L"3D/T_CH_CompanionAngry_m.dds", L"3D/T_CH_CompanionAngry_fx.dds");
 }
 
 void CompanionBehavior::SetTexture()
 {
-	std::wstring nameC;
-	std::wstring nameN;
-	std::wstring nameM;
-	std::wstring nameFX;
+	// Runs every update, so it only hands the model pointers looked up in InitTextures
+	if (GetOrder() == myTextureOrder)
+		return;
+	myTextureOrder = GetOrder();
 
-	switch (GetOrder())
-	{
-	case CompanionBehavior::Orders::Fetch:
-	{
-		nameC = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_CompanionHappy_c.dds");
-		nameN = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_CompanionHappy_n.dds");
-		nameM = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_CompanionHappy_m.dds");
-		nameFX = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_CompanionHappy_fx.dds");
-		Texture(nameC.c_str(), nameN.c_str(), nameM.c_str(), nameFX.c_str());
+	const TextureSet& textures = myTextures[static_cast<size_t>(myTextureOrder)];
+	if (textures.color == nullptr)
+		return;
 
-		break;
-	}
-	case CompanionBehavior::Orders::FollowPlayer:
-	{
-		nameC = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_Companion_c.dds");
-		nameN = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_Companion_n.dds");
-		nameM = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_Companion_m.dds");
-		nameFX = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_Companion_fx.dds");
-		Texture(nameC.c_str(), nameN.c_str(), nameM.c_str(), nameFX.c_str());
-		break;
-	}
-	case CompanionBehavior::Orders::Turret:
+	for (size_t i = 0; i < context.modelInstance->GetModel()->GetMeshCount(); i++)
 	{
-		nameC = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_CompanionAngry_c.dds");
-		nameN = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_CompanionAngry_n.dds");
-		nameM = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_CompanionAngry_m.dds");
-		nameFX = DreamEngine::Settings::ResolveAssetPathW(L"3D/T_CH_CompanionAngry_fx.dds");
-		Texture(nameC.c_str(), nameN.c_str(), nameM.c_str(), nameFX.c_str());
-		break;
-	}
-	default:
-		break;
+		context.modelInstance->SetTexture(i, 0, textures.color);	// 0 = Colour
+		context.modelInstance->SetTexture(i, 1, textures.normal);	// 1 = Normal
+		context.modelInstance->SetTexture(i, 2, textures.material);	// 2 = Material
+		context.modelInstance->SetTexture(i, 3, textures.emissive); // 3 = FX Emissive 
 	}
 }
 
-void CompanionBehavior::Texture(const wchar_t* aColorPath, const wchar_t* aNormalPath, const wchar_t* aMaterialPath, const wchar_t* aEmissivePath)
+void CompanionBehavior::Texture(Orders anOrder, const wchar_t* aColorPath, const wchar_t* aNormalPath, const wchar_t* aMaterialPath, const wchar_t* aEmissivePath)
 {
-	DreamEngine::Engine& engine = *DreamEngine::Engine::GetInstance();
-	DreamEngine::Texture* textureC  = nullptr;
-	DreamEngine::Texture* textureN  = nullptr;
-	DreamEngine::Texture* textureM  = nullptr;
-	DreamEngine::Texture* textureFX = nullptr;
+	CompanionWorld& world = CompanionWorld::Get();
+	TextureSet& textures = myTextures[static_cast<size_t>(anOrder)];
 
-	textureC  = engine.GetTextureManager().GetTexture(aColorPath, true);
-	textureN  = engine.GetTextureManager().GetTexture(aNormalPath, false);
-	textureM  = engine.GetTextureManager().GetTexture(aMaterialPath, false);
-	textureFX = engine.GetTextureManager().GetTexture(aEmissivePath, false);
+	textures.color    = world.LoadTexture(aColorPath, true);
+	textures.normal   = world.LoadTexture(aNormalPath, false);
+	textures.material = world.LoadTexture(aMaterialPath, false);
+	textures.emissive = world.LoadTexture(aEmissivePath, false);
+}
 
-	for (size_t i = 0; i < context.modelInstance->GetModel()->GetMeshCount(); i++)
-	{
-		context.modelInstance->SetTexture(i, 0, textureC);	// 0 = Colour
-		context.modelInstance->SetTexture(i, 1, textureN);	// 1 = Normal
-		context.modelInstance->SetTexture(i, 2, textureM);	// 2 = Material
-		context.modelInstance->SetTexture(i, 3, textureFX); // 3 = FX Emissive 
-	}
+bool HaveNoOrder::Condition(TickContext& aContext)
+{
+	return !HaveOrder::Condition(aContext);
 }
 
-Node::Status HaveNoOrder::Update()
+Node::Status HaveNoOrder::Update(TickContext& aContext)
 {
-	//when no succsed
-	if (myController->GetOrder() == CompanionBehavior::Orders::Fetch ||
-		myController->GetOrder() == CompanionBehavior::Orders::Turret)
+	// Static trees check the condition before ticking, trees built at runtime still rely on this
+	if (!Condition(aContext))
 		return Status::Failure;
 
 	bool running = false;
 
-	for (size_t i = 0; i < myChildren.size(); i++)
+	for (size_t i = 0; i < GetChildCount(); i++)
 	{
-		myChildren[i]->Update();
-		if (myChildren[i]->CheckStatus(Status::Running))
+		if (UpdateChild(aContext, i) == Status::Running)
 		{
 			running = true;
 		}
@@ -266,219 +377,240 @@ Node::Status HaveNoOrder::Update()
 	return running ? Status::Running : Status::Success;
 }
 
-Node::Status HaveOrder::Update()
+bool HaveOrder::Condition(TickContext& aContext)
 {
-	if (myController->GetOrder() == CompanionBehavior::Orders::Turret)
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	return controller.GetOrder() == CompanionBehavior::Orders::Fetch ||
+		controller.GetOrder() == CompanionBehavior::Orders::Turret;
+}
+
+Node::Status HaveOrder::Update(TickContext& aContext)
+{
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	if (controller.GetOrder() == CompanionBehavior::Orders::Turret)
 	{
-		myChildren[1]->Update();
+		UpdateChild(aContext, 1);
 	}
-	else if (myController->GetOrder() == CompanionBehavior::Orders::Fetch)
+	else if (controller.GetOrder() == CompanionBehavior::Orders::Fetch)
 	{
-		myChildren[0]->Update();
+		UpdateChild(aContext, 0);
 	}
 
-	return myController->GetOrder() == CompanionBehavior::Orders::FollowPlayer ? Status::Failure : Status::Success;
+	return controller.GetOrder() == CompanionBehavior::Orders::FollowPlayer ? Status::Failure : Status::Success;
 }
 
-Node::Status FollowPlayer::Update()
+Node::Status FollowPlayer::Update(TickContext& aContext)
 {
-	if (myController->GetOrder() != CompanionBehavior::Orders::FollowPlayer)
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	if (controller.GetOrder() != CompanionBehavior::Orders::FollowPlayer)
 		return Status::Failure;
 
-	for (size_t i = 0; i < myChildren.size(); i++)
+	for (size_t i = 0; i < GetChildCount(); i++)
 	{
-		myChildren[i]->Update();
+		UpdateChild(aContext, i);
 	}
 
-	myController->SetOrder(CompanionBehavior::Orders::FollowPlayer);
-	myController->context.targetPosition = myController->context.playerPos;
+	controller.SetOrder(CompanionBehavior::Orders::FollowPlayer);
+	controller.context.targetPosition = controller.blackboard.Get<CompanionKey::PlayerPos>();
 
 	return Status::Running;
 }
 
-Node::Status Fetch::Update()
+Node::Status Fetch::Update(TickContext& aContext)
 {
-	if (!myController->context.hasPickedUp)
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	if (!controller.context.hasPickedUp)
 	{
-		myChildren[0]->Update();
+		UpdateChild(aContext, 0);
 		return Status::Running;
 	}
 	else
 	{
-		myChildren[1]->Update();
+		UpdateChild(aContext, 1);
 		return Status::Running;
 	}
 
 	return Status::Success;
 }
 
-Node::Status Turret::Update()
+Node::Status Turret::Update(TickContext& aContext)
 {
-	if (!myController->context.turretCooldown.ReachedThreshold())	//on cooldown
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	if (!controller.IsTimerDone(controller.context.turretCooldown))	//on cooldown
 	{
-		myController->SetOrder(CompanionBehavior::Orders::FollowPlayer);
+		controller.SetOrder(CompanionBehavior::Orders::FollowPlayer);
 		return Status::Failure;
 	}
 
-	if (myController->context.turretPosition.Length() == 0)
+	if (controller.context.turretPosition.Length() == 0)
 	{
-		myController->context.turretPosition = myController->context.playerPos;
-		myController->context.turretPosition.y += myController->context.rayLength;
-		myController->context.turretTimer.Reset();
+		controller.context.turretPosition = controller.blackboard.Get<CompanionKey::PlayerPos>();
+		controller.context.turretPosition.y += controller.context.rayLength;
+		controller.RestartTimer(controller.context.turretTimer);
 
-		bool activationMessageData = true;
-		MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ &activationMessageData, eMessageType::CompanionTurretActive });
+		controller.GetCommands().TriggerMessage(eMessageType::CompanionTurretActive, true);
 
-		MainSingleton::GetInstance()->GetAudioManager().StopAudio(eAudioEvent::CompanionVL1);
-		MainSingleton::GetInstance()->GetAudioManager().PlayAudio(eAudioEvent::CompanionVL1, myController->context.transform.GetPosition());
+		controller.GetCommands().PlayAudio(eAudioEvent::CompanionVL1, controller.blackboard.Get<CompanionKey::Transform>().GetPosition());
 
 		//sending message to HUD & projectile
-		bool deactivationMessageData = false;
-		MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ &deactivationMessageData, eMessageType::CompanionTurretCooldownToggle });
-		MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ &deactivationMessageData, eMessageType::CompanionTurretActive });
+		controller.GetCommands().TriggerMessage(eMessageType::CompanionTurretCooldownToggle, false);
+		controller.GetCommands().TriggerMessage(eMessageType::CompanionTurretActive, false);
 	}
 
-	if (myController->context.turretTimer.ReachedThreshold())	//is done
+	if (controller.IsTimerDone(controller.context.turretTimer))	//is done
 	{
-		myController->SetOrder(CompanionBehavior::Orders::FollowPlayer);
+		controller.SetOrder(CompanionBehavior::Orders::FollowPlayer);
 
-		myController->context.turretPosition = 0.0f;
-		myController->context.turretCooldown.Reset();
-		myController->context.hasSentCoolDownMSG = false;
+		controller.context.turretPosition = 0.0f;
+		controller.RestartTimer(controller.context.turretCooldown);
+		controller.context.hasSentCoolDownMSG = false;
 
 		return Status::Success;
 	}
 
-	myChildren[0]->Update();
+	UpdateChild(aContext, 0);
 
-	myController->SetOrder(CompanionBehavior::Orders::Turret);
-	myController->context.targetPosition = myController->context.turretPosition;
+	controller.SetOrder(CompanionBehavior::Orders::Turret);
+	controller.context.targetPosition = controller.context.turretPosition;
 	return Status::Running;
 }
 
-Node::Status PickUp::Update()
+Node::Status PickUp::Update(TickContext& aContext)
 {
-	if (!myController->context.healCooldown.ReachedThreshold()) 
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	if (!controller.IsTimerDone(controller.context.healCooldown)) 
 	{ 
-		myController->SetOrder(CompanionBehavior::Orders::FollowPlayer);
+		controller.SetOrder(CompanionBehavior::Orders::FollowPlayer);
 		return Status::Failure;
 	}
 
-	bool deactivationMessageData = false;
-	MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ &deactivationMessageData, eMessageType::CompanionHealthCooldownToggle });
+	controller.GetCommands().TriggerMessage(eMessageType::CompanionHealthCooldownToggle, false);
 
-	DreamEngine::Vector3f Hpos = myController->context.closesHealingStation;
-	Hpos.y += myController->context.rayLength;
+	DreamEngine::Vector3f Hpos = controller.blackboard.Get<CompanionKey::HealingStation>();
+	Hpos.y += controller.context.rayLength;
 
-	DreamEngine::Vector3f Cpos = myController->context.transform.GetPosition();
+	DreamEngine::Vector3f Cpos = controller.blackboard.Get<CompanionKey::Transform>().GetPosition();
 	DreamEngine::Vector3f target = Hpos - Cpos;
 
 	float dist = (target).Length();
 	if (dist < PickupDistance)
 	{
-		myController->context.hasPickedUp = true;
-		myController->context.modelInstanceHealthPack->SetTransform(myController->context.transform);
+		controller.context.hasPickedUp = true;
+		controller.MarkChanged(CompanionField::HasPickedUp);
+		if (controller.context.modelInstanceHealthPack)
+			controller.context.modelInstanceHealthPack->SetTransform(controller.blackboard.Get<CompanionKey::Transform>());
 		return Status::Success;
 	}
 
-	myController->SetOrder(CompanionBehavior::Orders::Fetch);
-	myController->context.targetPosition = Hpos;
+	controller.SetOrder(CompanionBehavior::Orders::Fetch);
+	controller.context.targetPosition = Hpos;
 	return Status::Running;
 }
 
-Node::Status DropOff::Update()
+Node::Status DropOff::Update(TickContext& aContext)
 {
-	DreamEngine::Vector3f Ppos = myController->context.playerPos;
-	Ppos.y += myController->context.rayLength;
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	DreamEngine::Vector3f Ppos = controller.blackboard.Get<CompanionKey::PlayerPos>();
+	Ppos.y += controller.context.rayLength;
 
-	DreamEngine::Vector3f Cpos = myController->context.transform.GetPosition();
+	DreamEngine::Vector3f Cpos = controller.blackboard.Get<CompanionKey::Transform>().GetPosition();
 	DreamEngine::Vector3f target = Ppos - Cpos;
 	float dist = (target).Length();
 
 	// updating health pack transform
-	auto transformH = myController->context.transform;
+	auto transformH = controller.blackboard.Get<CompanionKey::Transform>();
 	DE::Vector3f posH = transformH.GetPosition();
 	posH.y -= healtPackOffset;
 
 	transformH.SetPosition(posH);
-	myController->context.modelInstanceHealthPack->SetTransform(transformH);
+	if (controller.context.modelInstanceHealthPack)
+		controller.context.modelInstanceHealthPack->SetTransform(transformH);
 
 	if (dist < DropDistance)
 	{
-		MainSingleton::GetInstance()->GetPostMaster().TriggerMessage({ nullptr, eMessageType::PlayerTriggerHeal });
+		controller.GetCommands().TriggerMessage(eMessageType::PlayerTriggerHeal);
 
-		myController->context.everyOtherHealing = !myController->context.everyOtherHealing;
-		if (myController->context.everyOtherHealing)
+		controller.context.everyOtherHealing = !controller.context.everyOtherHealing;
+		if (controller.context.everyOtherHealing)
 		{
-			MainSingleton::GetInstance()->GetAudioManager().StopAudio(eAudioEvent::CompanionHealing1);
-			MainSingleton::GetInstance()->GetAudioManager().PlayAudio(eAudioEvent::CompanionHealing1, myController->context.transform.GetPosition());
+			controller.GetCommands().PlayAudio(eAudioEvent::CompanionHealing1, controller.blackboard.Get<CompanionKey::Transform>().GetPosition());
 		}
 		else
 		{
-			MainSingleton::GetInstance()->GetAudioManager().StopAudio(eAudioEvent::CompanionHealing2);
-			MainSingleton::GetInstance()->GetAudioManager().PlayAudio(eAudioEvent::CompanionHealing2, myController->context.transform.GetPosition());
+			controller.GetCommands().PlayAudio(eAudioEvent::CompanionHealing2, controller.blackboard.Get<CompanionKey::Transform>().GetPosition());
 		}
 
-		myController->context.hasHealingCoolDown = true;
-		myController->context.healCooldown.Reset();
+		controller.context.hasHealingCoolDown = true;
+		controller.RestartTimer(controller.context.healCooldown);
 
-		myController->context.hasPickedUp = false;
-		myController->SetOrder(CompanionBehavior::Orders::FollowPlayer);
+		controller.context.hasPickedUp = false;
+		controller.MarkChanged(CompanionField::HasPickedUp);
+		controller.SetOrder(CompanionBehavior::Orders::FollowPlayer);
 
 		return Status::Success;
 	}
 
-	myController->SetOrder(CompanionBehavior::Orders::Fetch);
-	myController->context.targetPosition = Ppos;
+	controller.SetOrder(CompanionBehavior::Orders::Fetch);
+	controller.context.targetPosition = Ppos;
 	return Status::Running;
 }
 
-Node::Status ShootEnemy::Update()
+Node::Status ShootEnemy::Update(TickContext& aContext)
 {
-	if (!myController->context.shootTimer.ReachedThreshold() ||
-		myController->context.noShooting == true ||
-		!myController->context.seesEnemy)
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	if (!controller.IsTimerDone(controller.context.shootTimer) ||
+		controller.context.noShooting == true ||
+		!controller.blackboard.Get<CompanionKey::SeesEnemy>())
 		return Status::Running;
 
-	myController->context.shootTimer.Reset();
+	controller.RestartTimer(controller.context.shootTimer);
 
-	DE::Vector3f enemyPosition = myController->context.enemyPosition;
-	DE::Vector3f companionPosition = myController->context.transform.GetPosition();
+	DE::Vector3f enemyPosition = controller.blackboard.Get<CompanionKey::EnemyPosition>();
+	DE::Vector3f companionPosition = controller.blackboard.Get<CompanionKey::Transform>().GetPosition();
 	DE::Vector3f dirToEnemy = DE::Vector3f(enemyPosition - companionPosition);
 
-	myController->context.projectilePool->GetProjectile(
-		companionPosition, dirToEnemy.GetNormalized(), myController->context.enemyTransform);
+	controller.GetCommands().SpawnProjectile(controller.context.projectilePool,
+		companionPosition, dirToEnemy.GetNormalized(), controller.blackboard.Get<CompanionKey::EnemyTransform>());
 
-	MainSingleton::GetInstance()->GetAudioManager().StopAudio(eAudioEvent::CompanionShoot);
-	MainSingleton::GetInstance()->GetAudioManager().PlayAudio(eAudioEvent::CompanionShoot, myController->context.transform.GetPosition());
+	controller.GetCommands().PlayAudio(eAudioEvent::CompanionShoot, controller.blackboard.Get<CompanionKey::Transform>().GetPosition());
 
 	return Status::Success;
 }
 
-Node::Status Intro::Update()
+Node::Status Intro::Update(TickContext& aContext)
 {
-	if (myController->GetOrder() == CompanionBehavior::Orders::FollowPlayer || !myController->context.hasWokenUp)	// add this when thea is finished with cam movement!
+	CompanionBehavior& controller = aContext.GetAgent<CompanionBehavior>();
+
+	if (controller.GetOrder() == CompanionBehavior::Orders::FollowPlayer || !controller.context.hasWokenUp)	// add this when thea is finished with cam movement!
 		return Status::Failure;
 
-	if (myController->context.introPosition.Length() == 0.0f)
+	aContext.AddReadMask(CompanionField::Transform);
+	if (controller.context.introPosition.Length() == 0.0f)
 	{
-		DE::Vector3f pos = myController->context.transform.GetPosition();
+		DE::Vector3f pos = controller.blackboard.Get<CompanionKey::Transform>().GetPosition();
 		pos.y += introHeightOffset;
-		myController->context.introPosition = pos;
+		controller.context.introPosition = pos;
 
-		MainSingleton::GetInstance()->GetAudioManager().StopAudio(eAudioEvent::CompanionIntroduction);
-		MainSingleton::GetInstance()->GetAudioManager().PlayAudio(eAudioEvent::CompanionIntroduction, myController->context.transform.GetPosition());
+		controller.GetCommands().PlayAudio(eAudioEvent::CompanionIntroduction, controller.blackboard.Get<CompanionKey::Transform>().GetPosition());
 	}
 
-	float lenght = (myController->context.introPosition - myController->context.transform.GetPosition()).Length();
+	float lenght = (controller.context.introPosition - controller.blackboard.Get<CompanionKey::Transform>().GetPosition()).Length();
 	if (lenght < introCompletionDistance && lenght != 0.0f)
 	{
-		myController->SetOrder(CompanionBehavior::Orders::FollowPlayer);
+		controller.SetOrder(CompanionBehavior::Orders::FollowPlayer);
 		return Status::Success;
 	}
 	else
 	{
-		myController->context.targetPosition = myController->context.introPosition;
+		controller.context.targetPosition = controller.context.introPosition;
 		return Status::Running;
 	}
 }
\ No newline at end of file
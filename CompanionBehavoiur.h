@@ -1,39 +1,115 @@
 #pragma once
 #include "BehaviourTree.h"
 #include "CompanionContext.h"
-#include "MainSingleton.h"
+#include "CompanionCommandBuffer.h"
 #include "CompanionTreeNodes.h"
+#include "BehaviourTreeAsset.h"
 
 #include <DreamEngine/graphics/ModelInstance.h>
 #include <DreamEngine/graphics/GraphicsEngine.h>
 #include <DreamEngine/math/Vector.h>
 #include <DreamEngine/math/Matrix.h>
+#include <array>
 #include <memory>
 #include <vector>
 #include <utility> 
 
+namespace DreamEngine
+{
+	class Texture;
+}
+
 class CompanionBehavior
 {
 public:
 	enum class Orders { FollowPlayer, Fetch, Turret, Intro };
 
+	static constexpr size_t ourMaxAssetNodeCount = 64;
+
+	// Everything the behaviour changes while it runs, as plain data. Sensed values are left out, they are
+	// written again on the next update. Projectiles in flight are not part of it.
+	struct Snapshot
+	{
+		CompanionTreeDefinition::State treeState;
+		BehaviourTreeState<ourMaxAssetNodeCount> assetTreeState;
+		uint32_t assetGeneration;
+
+		// Seconds left on each timer, 0 when expired
+		float turretTimer;
+		float shootTimer;
+		float turretCooldown;
+		float healCooldown;
+		float conversationTimer;
+
+		DreamEngine::Vector3f targetPosition;
+		DreamEngine::Vector3f turretPosition;
+		DreamEngine::Vector3f introPosition;
+
+		Orders order;
+
+		bool hasPickedUp;
+		bool noShooting;
+		bool hasSentCoolDownMSG;
+		bool hasHealingCoolDown;
+		bool hasWokenUp;
+		bool everyOtherHealing;
+	};
+
 	CompanionBehavior();
 	~CompanionBehavior();
 
+	// The timers call back into the behaviour that created them
+	CompanionBehavior(const CompanionBehavior&) = delete;
+	CompanionBehavior& operator=(const CompanionBehavior&) = delete;
+
 	void Init(std::shared_ptr<DreamEngine::ModelInstance> aModel);
 	DreamEngine::Vector3f Update(float aDeltaTime);
-	void Render(DE::GraphicsEngine& aGraphicsEngine);
+	void UpdateTree();
+	DreamEngine::Vector3f UpdateState(float aDeltaTime);
+
+	void Save(Snapshot& aSnapshot) const;
+	void Restore(const Snapshot& aSnapshot);
 
-	void SetContext(const CompanionContext& someStateToRead);
+	// Runs the tree loaded by aResource instead of the built in CompanionTree, nullptr switches back.
+	// Trees from assets are ticked every update and one agent at a time.
+	void SetTreeResource(const std::shared_ptr<BehaviourTreeResource>& aResource);
+
+	// Ticks the trees of many companions in lockstep, see StaticBehaviourTree::UpdateBatch
+	static void UpdateTrees(const std::vector<CompanionBehavior*>& someBehaviors, TickBatch& aBatch);
+	void Render(DE::GraphicsEngine& aGraphicsEngine);
 
 	Orders GetOrder() { return myOrder; }
-	void SetOrder(Orders aOrder) { myOrder = aOrder; }
+	void SetOrder(Orders aOrder)
+	{
+		if (aOrder != myOrder)
+			MarkChanged(CompanionField::Order);
+		myOrder = aOrder;
+	}
+
+	// Side effects of this update go to the buffer set here, or to the companion's own buffer when none is set
+	void SetCommandBuffer(CompanionCommandBuffer* aBuffer) { myCommands = aBuffer; }
+	CompanionCommandBuffer& GetCommands() { return myCommands ? *myCommands : myOwnCommands; }
+	void FlushCommands() { myOwnCommands.Flush(); }
+
+	// Timers run in the wheel set here, or in the companion's own wheel when none is set. Running timers
+	// are moved over with the time they have left.
+	void SetTimerWheel(TimerWheel* aWheel);
+	TimerWheel& GetTimers() { return myTimers ? *myTimers : myOwnTimers; }
+	const TimerWheel& GetTimers() const { return myTimers ? *myTimers : myOwnTimers; }
+	bool IsTimerDone(TimerHandle aTimer) const { return GetTimers().IsExpired(aTimer); }
+	void RestartTimer(TimerHandle aTimer);
+
+	// Flags context fields as changed so the tree re-evaluates the branches reading them next update
+	void MarkChanged(uint32_t someFields) { myChangedFields |= someFields; }
 
 	void InitAudio();
 	void PlayRandomSound();
 
+	void InitTextures();
+	// Swaps the model to the textures of the current order, looked up once by InitTextures
 	void SetTexture();
-	void Texture(const wchar_t* aColorPath,
+	void Texture(Orders anOrder,
+		const wchar_t* aColorPath,
 		const wchar_t* aNormalPath,
 		const wchar_t* aMaterialPath,
 		const wchar_t* aEmessivePath);
@@ -47,10 +123,36 @@ public:
 		return result;
 	}
 
+	CompanionBlackboard blackboard;
 	CompanionContext context;
 
 private:
+	uint32_t TakeChangedFields();
+	static void OnTimerExpired(void* aBehavior, uint32_t someFields);
+
 	Orders myOrder = Orders::Intro;
-	std::shared_ptr<BehaviourTree> myBehaviourTree;
+	struct TextureSet
+	{
+		DreamEngine::Texture* color = nullptr;
+		DreamEngine::Texture* normal = nullptr;
+		DreamEngine::Texture* material = nullptr;
+		DreamEngine::Texture* emissive = nullptr;
+	};
+
+	// One set per order, Intro has none and leaves the model's textures as they are
+	std::array<TextureSet, 4> myTextures;
+	// Order the model's textures were last set for
+	Orders myTextureOrder = Orders::Intro;
+	uint32_t myChangedFields = CompanionField::All;
+	CompanionTreeDefinition::State myTreeState = {};
+
+	std::shared_ptr<BehaviourTreeResource> myTreeResource;
+	std::shared_ptr<FlatBehaviourTree> myAssetTree;
+	uint32_t myAssetGeneration = 0;
+	BehaviourTreeState<ourMaxAssetNodeCount> myAssetTreeState = {};
+	CompanionCommandBuffer myOwnCommands;
+	CompanionCommandBuffer* myCommands = nullptr;
+	TimerWheel myOwnTimers;
+	TimerWheel* myTimers = nullptr;
 	std::vector<eAudioEvent> myAudios;
 };
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include "CompanionBenchmark.h"
+#include "CompanionAllocations.h"
+#include "CompanionBehavoiur.h"
+#include "CompanionSteeringBehavior.h"
+#include "CompanionSteeringBatch.h"
+#include "CompanionTargetGrid.h"
+#include "Companion.h"
+#include "FlyingEnemy.h"
+#include "GroundEnemy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	constexpr float frameTime = 1.0f / 60.0f;
+
+	// Results are written here so the measured calls can't be optimised away
+	volatile float resultSink;
+
+	struct Measurement
+	{
+		Clock::duration time = Clock::duration::zero();
+		long long allocations = 0;
+	};
+
+	long long GetAllocationCount()
+	{
+		return static_cast<long long>(CompanionAllocations::GetCount());
+	}
+
+	// Adds the time and allocations of one aFunction() call to aMeasurement
+	template <class Function>
+	void Measure(Measurement& aMeasurement, Function&& aFunction)
+	{
+		long long allocations = GetAllocationCount();
+		auto start = Clock::now();
+		aFunction();
+		aMeasurement.time += Clock::now() - start;
+		aMeasurement.allocations += GetAllocationCount() - allocations;
+	}
+
+	void Report(std::ostream& aStream, const char* aBenchmark, const char* aMode, size_t anAgentCount,
+		const Measurement& aMeasurement, size_t anOperationCount, size_t aBytesPerAgent)
+	{
+		double nanoseconds = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(aMeasurement.time).count());
+		aStream << aBenchmark << ',' << aMode << ',' << anAgentCount << ',' << nanoseconds / anOperationCount << ',';
+		if (CompanionAllocations::IsCounting())
+			aStream << static_cast<double>(aMeasurement.allocations) / anOperationCount;
+		else
+			aStream << -1;
+		aStream << ',' << aBytesPerAgent << '\n';
+	}
+
+	// Half of the companions follow the player, the other half wait for their intro. Neither branch
+	// sends messages or plays audio, so the numbers are the cost of the tree alone.
+	std::vector<std::unique_ptr<CompanionBehavior>> CreateBehaviors(size_t anAgentCount)
+	{
+		std::vector<std::unique_ptr<CompanionBehavior>> behaviors;
+		for (size_t i = 0; i < anAgentCount; i++)
+		{
+			behaviors.push_back(std::make_unique<CompanionBehavior>());
+			behaviors.back()->SetOrder(i % 2 == 0 ? CompanionBehavior::Orders::FollowPlayer : CompanionBehavior::Orders::Intro);
+		}
+		return behaviors;
+	}
+
+	// Companions on a ring around the origin, far enough from each other that their steering differs
+	DE::Transform GetAgentTransform(size_t anIndex, size_t anAgentCount)
+	{
+		float angle = 6.2831853f * static_cast<float>(anIndex) / static_cast<float>(anAgentCount);
+		float radius = 500.0f + 10.0f * static_cast<float>(anIndex % 50);
+
+		DE::Transform transform;
+		transform.SetPosition(DE::Vector3f(std::cos(angle) * radius, 200.0f, std::sin(angle) * radius));
+		transform.SetRotation(DE::Vector3f(0.0f, angle * 57.29578f, 0.0f));
+		return transform;
+	}
+
+	// A target circling the origin, as a player walking around would
+	DE::Vector3f GetTarget(size_t aFrame)
+	{
+		float angle = static_cast<float>(aFrame) * 0.05f;
+		return DE::Vector3f(std::cos(angle) * 300.0f, 200.0f, std::sin(angle) * 300.0f);
+	}
+}
+
+void CompanionBenchmark::WriteHeader(std::ostream& aStream)
+{
+	aStream << "benchmark,mode,agents,ns_per_op,allocs_per_op,bytes_per_agent\n";
+}
+
+bool CompanionBenchmark::Run(std::ostream& aStream, size_t aFrameCount)
+{
+	bool batchMatches = true;
+	WriteHeader(aStream);
+	for (size_t agentCount : { 10, 100, 1000 })
+	{
+		TreeTick(aStream, agentCount, aFrameCount);
+		SteeringUpdate(aStream, agentCount, aFrameCount);
+		if (SteeringBatchDeviation(agentCount, aFrameCount) > steeringBatchTolerance)
+			batchMatches = false;
+		Avoidance(aStream, agentCount, aFrameCount);
+		Rotation(aStream, agentCount, aFrameCount);
+	}
+	return batchMatches;
+}
+
+void CompanionBenchmark::TreeTick(std::ostream& aStream, size_t anAgentCount, size_t aFrameCount)
+{
+	auto behaviors = CreateBehaviors(anAgentCount);
+	std::vector<CompanionBehavior*> behaviorPointers;
+	for (auto& behavior : behaviors)
+		behaviorPointers.push_back(behavior.get());
+
+	// Changed fields are flagged every frame so the reactive skip never kicks in
+	Measurement perAgent;
+	for (size_t frame = 0; frame < aFrameCount; frame++)
+	{
+		for (CompanionBehavior* behavior : behaviorPointers)
+			behavior->MarkChanged(CompanionField::All);
+
+		Measure(perAgent, [&behaviorPointers]()
+			{
+				for (CompanionBehavior* behavior : behaviorPointers)
+					behavior->UpdateTree();
+			});
+	}
+
+	TickBatch batch;
+	Measurement lockstep;
+	for (size_t frame = 0; frame < aFrameCount; frame++)
+	{
+		for (CompanionBehavior* behavior : behaviorPointers)
+			behavior->MarkChanged(CompanionField::All);
+
+		Measure(lockstep, [&behaviorPointers, &batch]()
+			{
+				CompanionBehavior::UpdateTrees(behaviorPointers, batch);
+			});
+	}
+
+	Report(aStream, "TreeTick", "PerAgent", anAgentCount, perAgent, anAgentCount * aFrameCount, sizeof(CompanionBehavior));
+	Report(aStream, "TreeTick", "Lockstep", anAgentCount, lockstep, anAgentCount * aFrameCount, sizeof(CompanionBehavior));
+}
+
+void CompanionBenchmark::SteeringUpdate(std::ostream& aStream, size_t anAgentCount, size_t aFrameCount)
+{
+	std::vector<CompanionSteeringBehavior> steering(anAgentCount);
+	std::vector<DE::Transform> transforms(anAgentCount);
+	auto reset = [&]()
+		{
+			for (size_t i = 0; i < anAgentCount; i++)
+			{
+				transforms[i] = GetAgentTransform(i, anAgentCount);
+				steering[i] = CompanionSteeringBehavior();
+				steering[i].Init(transforms[i]);
+			}
+		};
+
+	reset();
+	Measurement update;
+	for (size_t frame = 0; frame < aFrameCount; frame++)
+	{
+		DE::Vector3f target = GetTarget(frame);
+		Measure(update, [&]()
+			{
+				for (size_t i = 0; i < anAgentCount; i++)
+				{
+					DE::Vector3f velocity = steering[i].Update(frameTime, transforms[i], target);
+					transforms[i].SetPosition(transforms[i].GetPosition() + velocity * frameTime);
+				}
+			});
+	}
+
+	// The same through a CompanionSteeringBatch, one companion per lane and then as many as the build allows
+	CompanionSteeringBatch batch;
+	Measurement batched[2];
+	for (int useLanes = 0; useLanes < 2; useLanes++)
+	{
+		reset();
+		for (size_t frame = 0; frame < aFrameCount; frame++)
+		{
+			DE::Vector3f target = GetTarget(frame);
+			Measure(batched[useLanes], [&]()
+				{
+					batch.Resize(anAgentCount);
+					for (size_t i = 0; i < anAgentCount; i++)
+						steering[i].BeginUpdate(frameTime, transforms[i], target, batch, i);
+
+					if (useLanes != 0)
+						batch.Update();
+					else
+						batch.UpdateScalar();
+
+					for (size_t i = 0; i < anAgentCount; i++)
+					{
+						DE::Vector3f velocity = steering[i].EndUpdate(batch, i);
+						transforms[i].SetPosition(transforms[i].GetPosition() + velocity * frameTime);
+					}
+				});
+		}
+	}
+
+	size_t batchBytes = sizeof(CompanionSteeringBehavior) + CompanionSteeringBatch::GetBytesPerAgent();
+	Report(aStream, "SteeringUpdate", "Update", anAgentCount, update, anAgentCount * aFrameCount, sizeof(CompanionSteeringBehavior));
+	Report(aStream, "SteeringUpdate", "BatchScalar", anAgentCount, batched[0], anAgentCount * aFrameCount, batchBytes);
+	Report(aStream, "SteeringUpdate", "BatchLanes", anAgentCount, batched[1], anAgentCount * aFrameCount, batchBytes);
+}
+
+float CompanionBenchmark::SteeringBatchDeviation(size_t anAgentCount, size_t aFrameCount)
+{
+	std::vector<CompanionSteeringBehavior> steering(anAgentCount);
+	std::vector<DE::Transform> transforms(anAgentCount);
+	for (size_t i = 0; i < anAgentCount; i++)
+	{
+		transforms[i] = GetAgentTransform(i, anAgentCount);
+		steering[i].Init(transforms[i]);
+	}
+
+	// Every frame the three start from copies of the same behaviours, so a difference can't grow over frames
+	std::vector<CompanionSteeringBehavior> scalarSteering;
+	std::vector<CompanionSteeringBehavior> laneSteering;
+	CompanionSteeringBatch scalarBatch;
+	CompanionSteeringBatch laneBatch;
+	float deviation = 0.0f;
+	for (size_t frame = 0; frame < aFrameCount; frame++)
+	{
+		DE::Vector3f target = GetTarget(frame);
+		scalarSteering = steering;
+		laneSteering = steering;
+		scalarBatch.Resize(anAgentCount);
+		laneBatch.Resize(anAgentCount);
+		for (size_t i = 0; i < anAgentCount; i++)
+		{
+			scalarSteering[i].BeginUpdate(frameTime, transforms[i], target, scalarBatch, i);
+			laneSteering[i].BeginUpdate(frameTime, transforms[i], target, laneBatch, i);
+		}
+		scalarBatch.UpdateScalar();
+		laneBatch.Update();
+
+		for (size_t i = 0; i < anAgentCount; i++)
+		{
+			DE::Vector3f velocity = steering[i].Update(frameTime, transforms[i], target);
+			deviation = std::max(deviation, (scalarSteering[i].EndUpdate(scalarBatch, i) - velocity).Length());
+			deviation = std::max(deviation, (laneSteering[i].EndUpdate(laneBatch, i) - velocity).Length());
+			transforms[i].SetPosition(transforms[i].GetPosition() + velocity * frameTime);
+		}
+	}
+	return deviation;
+}
+
+void CompanionBenchmark::Avoidance(std::ostream& aStream, size_t anAgentCount, size_t aFrameCount)
+{
+	std::vector<CompanionSteeringBehavior> steering(anAgentCount);
+	for (size_t i = 0; i < anAgentCount; i++)
+		steering[i].Init(GetAgentTransform(i, anAgentCount));
+
+	Measurement flee;
+	for (size_t frame = 0; frame < aFrameCount; frame++)
+	{
+		Measure(flee, [&steering]()
+			{
+				for (CompanionSteeringBehavior& agent : steering)
+					agent.FleeForce();
+			});
+	}
+
+	Report(aStream, "Avoidance", "FleeForce", anAgentCount, flee, anAgentCount * aFrameCount, sizeof(CompanionSteeringBehavior));
+}
+
+void CompanionBenchmark::Rotation(std::ostream& aStream, size_t anAgentCount, size_t aFrameCount)
+{
+	CompanionSteeringBehavior steering;
+	std::vector<DE::Vector3f> points(anAgentCount);
+	std::vector<CompanionOrientation> rotations(anAgentCount);
+	for (size_t i = 0; i < anAgentCount; i++)
+		points[i] = GetAgentTransform(i, anAgentCount).GetPosition() - GetTarget(i);
+
+	float sum = 0.0f;
+	Measurement rotateToThis;
+	Measurement overTime;
+	for (size_t frame = 0; frame < aFrameCount; frame++)
+	{
+		Measure(rotateToThis, [&]()
+			{
+				for (const DE::Vector3f& point : points)
+					sum += steering.RotateToThis(point).w;
+			});
+		Measure(overTime, [&]()
+			{
+				for (size_t i = 0; i < anAgentCount; i++)
+					rotations[i] = steering.RotateToThisOverTime(points[i], frameTime, 5.0f, rotations[i]);
+			});
+	}
+
+	// Handing the orientation to the engine, once per companion and frame
+	DE::Vector3f eulerSum;
+	Measurement toEuler;
+	for (size_t frame = 0; frame < aFrameCount; frame++)
+	{
+		Measure(toEuler, [&]()
+			{
+				for (const CompanionOrientation& rotation : rotations)
+					eulerSum += rotation.GetEulerAnglesDegrees();
+			});
+	}
+
+	Report(aStream, "Rotation", "RotateToThis", anAgentCount, rotateToThis, anAgentCount * aFrameCount, 0);
+	Report(aStream, "Rotation", "RotateToThisOverTime", anAgentCount, overTime, anAgentCount * aFrameCount, sizeof(CompanionOrientation));
+	Report(aStream, "Rotation", "EulerAngles", anAgentCount, toEuler, anAgentCount * aFrameCount, 0);
+	resultSink = sum + rotations[0].x + eulerSum.y;
+}
+
+void CompanionBenchmark::TargetSelection(std::ostream& aStream, Companion& aCompanion,
+	const std::vector<std::shared_ptr<FlyingEnemy>>& someFlyingEnemies,
+	const std::vector<std::shared_ptr<GroundEnemy>>& someGroundEnemies, size_t aRepeatCount)
+{
+	CompanionBehavior& behavior = aCompanion.GetBehavior();
+	size_t available = someFlyingEnemies.size() + someGroundEnemies.size();
+
+	for (size_t enemyCount : { 10, 100, 1000, 10000 })
+	{
+		if (enemyCount > available)
+			break;
+
+		// Half flying and half on the ground where there are enough of both
+		size_t flyingCount = std::min(someFlyingEnemies.size(), enemyCount / 2);
+		size_t groundCount = std::min(someGroundEnemies.size(), enemyCount - flyingCount);
+		flyingCount = enemyCount - groundCount;
+
+		std::vector<std::shared_ptr<FlyingEnemy>> flying(someFlyingEnemies.begin(), someFlyingEnemies.begin() + flyingCount);
+		std::vector<std::shared_ptr<GroundEnemy>> ground(someGroundEnemies.begin(), someGroundEnemies.begin() + groundCount);
+
+		Measurement select;
+		for (size_t i = 0; i < aRepeatCount; i++)
+		{
+			// Target selection only runs when the companion may shoot
+			behavior.GetTimers().Start(behavior.context.shootTimer, 0.0f);
+			Measure(select, [&]()
+				{
+					aCompanion.SetTargetedEnemyPos(flying, ground);
+				});
+		}
+
+		// The same selection through a grid, and keeping the grid in line with the enemies every frame
+		CompanionTargetGrid grid(behavior.context.shootingLength);
+		Measurement sync;
+		Measurement gridSelect;
+		for (size_t i = 0; i < aRepeatCount; i++)
+		{
+			Measure(sync, [&]()
+				{
+					grid.Sync(flying, ground);
+				});
+
+			behavior.GetTimers().Start(behavior.context.shootTimer, 0.0f);
+			Measure(gridSelect, [&]()
+				{
+					aCompanion.SetTargetedEnemy(grid);
+				});
+		}
+
+		char mode[32];
+		std::snprintf(mode, sizeof(mode), "Enemies%zu", enemyCount);
+		Report(aStream, "TargetSelection", mode, 1, select, aRepeatCount, sizeof(Companion));
+		std::snprintf(mode, sizeof(mode), "GridEnemies%zu", enemyCount);
+		Report(aStream, "TargetSelection", mode, 1, gridSelect, aRepeatCount, sizeof(Companion));
+		std::snprintf(mode, sizeof(mode), "GridSync%zu", enemyCount);
+		Report(aStream, "TargetSelection", mode, 1, sync, aRepeatCount, 0);
+	}
+}
+
+void CompanionBenchmark::HealingStation(std::ostream& aStream, Companion& aCompanion, size_t aRepeatCount)
+{
+	DE::Vector3f sum;
+	Measurement closest;
+	Measure(closest, [&]()
+		{
+			for (size_t i = 0; i < aRepeatCount; i++)
+				sum += aCompanion.CalculateClosesHealingStation();
+		});
+
+	Report(aStream, "HealingStation", "Closest", 1, closest, aRepeatCount, sizeof(Companion));
+	resultSink = sum.x;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <memory>
+#include <ostream>
+#include <vector>
+
+class Companion;
+class FlyingEnemy;
+class GroundEnemy;
+
+// In-game benchmarks for the companion AI. Every benchmark writes one CSV line per measured mode:
+// benchmark,mode,agents,ns_per_op,allocs_per_op,bytes_per_agent
+// Allocations are only counted in builds with COMPANION_COUNT_ALLOCATIONS defined, see
+// CompanionAllocations.h, and are reported as -1 otherwise. bytes_per_agent is the size of the
+// state the benchmarked code keeps per companion. Steering and avoidance raycast against the
+// CompanionWorld in use.
+namespace CompanionBenchmark
+{
+	// Units per second the batched steering may differ from Update by, rounding and the order of operations
+	constexpr float steeringBatchTolerance = 0.01f;
+
+	// Writes the CSV header line
+	void WriteHeader(std::ostream& aStream);
+
+	// Runs every benchmark that needs no game objects for 10, 100 and 1000 agents. Returns false if the
+	// steering batch differs from Update by more than steeringBatchTolerance, in any build.
+	bool Run(std::ostream& aStream, size_t aFrameCount);
+
+	// Ticks the companion tree for anAgentCount companions, first one agent at a time and then in lockstep
+	void TreeTick(std::ostream& aStream, size_t anAgentCount, size_t aFrameCount);
+
+	// CompanionSteeringBehavior::Update for anAgentCount companions spread around a moving target
+	void SteeringUpdate(std::ostream& aStream, size_t anAgentCount, size_t aFrameCount);
+
+	// Steps anAgentCount companions with Update, and with the batch's UpdateScalar and Update, from the same
+	// state every frame and returns the largest difference between the velocities they give.
+	float SteeringBatchDeviation(size_t anAgentCount, size_t aFrameCount);
+
+	// FleeForce on its own, which probes the environment through DirectionAvoidance
+	void Avoidance(std::ostream& aStream, size_t anAgentCount, size_t aFrameCount);
+
+	// RotateToThis and RotateToThisOverTime towards anAgentCount different points, and their Euler angles
+	void Rotation(std::ostream& aStream, size_t anAgentCount, size_t aFrameCount);
+
+	// Companion::SetTargetedEnemyPos against the first 10, 100, 1000 and 10000 of the given enemies, as
+	// far as there are enough, then SetTargetedEnemy through a CompanionTargetGrid and the grid's Sync.
+	// Leaves aCompanion targeting the closest of the last set.
+	void TargetSelection(std::ostream& aStream, Companion& aCompanion,
+		const std::vector<std::shared_ptr<FlyingEnemy>>& someFlyingEnemies,
+		const std::vector<std::shared_ptr<GroundEnemy>>& someGroundEnemies, size_t aRepeatCount);
+
+	// Companion::CalculateClosesHealingStation over the stations aCompanion has been given
+	void HealingStation(std::ostream& aStream, Companion& aCompanion, size_t aRepeatCount);
+}
@@ -0,0 +1,113 @@
+#include "CompanionCommandBuffer.h"
+#include "CompanionWorld.h"
+#include "ProjectilePool.h"
+
+#include <algorithm>
+
+void CompanionCommandBuffer::TriggerMessage(eMessageType aType)
+{
+	Command command = {};
+	command.type = Type::Message;
+	command.messageType = aType;
+	myCommands.push_back(command);
+}
+
+void CompanionCommandBuffer::TriggerMessage(eMessageType aType, bool aValue)
+{
+	Command command = {};
+	command.type = Type::ValueMessage;
+	command.messageType = aType;
+	command.value = aValue;
+	myCommands.push_back(command);
+}
+
+void CompanionCommandBuffer::PlayAudio(eAudioEvent anEvent, const DreamEngine::Vector3f& aPosition)
+{
+	Command command = {};
+	command.type = Type::PlayAudio;
+	command.audioEvent = anEvent;
+	command.position = aPosition;
+	myCommands.push_back(command);
+}
+
+void CompanionCommandBuffer::SpawnProjectile(ProjectilePool* aPool, const DreamEngine::Vector3f& aPosition,
+	const DreamEngine::Vector3f& aDirection, DreamEngine::Transform* aTarget)
+{
+	Command command = {};
+	command.type = Type::SpawnProjectile;
+	command.pool = aPool;
+	command.position = aPosition;
+	command.direction = aDirection;
+	command.target = aTarget;
+	myCommands.push_back(command);
+}
+
+void CompanionCommandBuffer::Flush()
+{
+	if (myCommands.empty())
+		return;
+
+	CompanionWorld& world = CompanionWorld::Get();
+
+	// Value messages set a state, sending the value a message already has this flush changes nothing
+	mySentValues.clear();
+
+	// One pass per type in flush order instead of a stable sort, which would allocate a buffer every flush
+	for (Type type : { Type::Message, Type::ValueMessage, Type::PlayAudio, Type::SpawnProjectile })
+	{
+		for (size_t i = 0; i < myCommands.size(); i++)
+		{
+			const Command& command = myCommands[i];
+			if (command.type != type)
+				continue;
+
+			switch (command.type)
+			{
+			case Type::Message:
+			{
+				world.TriggerMessage({ nullptr, command.messageType });
+				break;
+			}
+			case Type::ValueMessage:
+			{
+				auto sent = std::find_if(mySentValues.begin(), mySentValues.end(), [&command](const std::pair<eMessageType, bool>& aSent)
+					{
+						return aSent.first == command.messageType;
+					});
+				if (sent == mySentValues.end())
+					mySentValues.push_back({ command.messageType, command.value });
+				else if (sent->second == command.value)
+					break;
+				else
+					sent->second = command.value;
+
+				bool value = command.value;
+				world.TriggerMessage({ &value, command.messageType });
+				break;
+			}
+			case Type::PlayAudio:
+			{
+				// Each play restarts the event, so only the last one recorded for an event is heard
+				auto restartedLater = std::find_if(myCommands.begin() + i + 1, myCommands.end(), [&command](const Command& aLater)
+					{
+						return aLater.type == Type::PlayAudio && aLater.audioEvent == command.audioEvent;
+					});
+				if (restartedLater != myCommands.end())
+					break;
+
+				world.StopAudio(command.audioEvent);
+				world.PlayAudio(command.audioEvent, command.position);
+				break;
+			}
+			case Type::SpawnProjectile:
+			{
+				if (command.pool != nullptr)
+					command.pool->GetProjectile(command.position, command.direction, command.target);
+				break;
+			}
+			}
+		}
+	}
+
+	myCommands.clear();
+}
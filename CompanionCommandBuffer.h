@@ -0,0 +1,53 @@
+#pragma once
+#include "Message.h"
+
+#include <DreamEngine/math/Vector.h>
+#include <DreamEngine/math/Transform.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+enum class eAudioEvent;
+class ProjectilePool;
+
+// Side effects recorded while the companions update, played back once per frame from the main thread.
+// Nodes append here instead of calling the PostMaster, AudioManager or ProjectilePool directly, so a tree
+// tick only writes to its own companion. Flush plays the commands back grouped by type, keeping their
+// recorded order within a type, and drops the ones that would have no effect.
+class CompanionCommandBuffer
+{
+public:
+	void TriggerMessage(eMessageType aType);
+	void TriggerMessage(eMessageType aType, bool aValue);
+
+	// Restarts anEvent at aPosition, the same as a StopAudio followed by a PlayAudio
+	void PlayAudio(eAudioEvent anEvent, const DreamEngine::Vector3f& aPosition);
+
+	void SpawnProjectile(ProjectilePool* aPool, const DreamEngine::Vector3f& aPosition,
+		const DreamEngine::Vector3f& aDirection, DreamEngine::Transform* aTarget);
+
+	void Flush();
+	void Clear() { myCommands.clear(); }
+
+	size_t GetCommandCount() const { return myCommands.size(); }
+
+private:
+	// Flush order, messages first so HUD state is updated before any sound or projectile is started
+	enum class Type: uint8_t { Message, ValueMessage, PlayAudio, SpawnProjectile };
+
+	struct Command
+	{
+		Type type;
+		bool value;
+		eMessageType messageType;
+		eAudioEvent audioEvent;
+		ProjectilePool* pool;
+		DreamEngine::Transform* target;
+		DreamEngine::Vector3f position;
+		DreamEngine::Vector3f direction;
+	};
+
+	std::vector<Command> myCommands;
+	// Kept between flushes so its capacity is too
+	std::vector<std::pair<eMessageType, bool>> mySentValues;
+};
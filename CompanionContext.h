@@ -2,27 +2,87 @@
 #include <DreamEngine/math/Matrix4x4.h>
 #include <DreamEngine/math/Vector.h>
 #include <DreamEngine/math/Transform.h>
-#include <DreamEngine/utilities/CountTimer.h>
 #include <DreamEngine/graphics/ModelInstance.h>
+#include "Blackboard.h"
+#include "TimerWheel.h"
 
 class ProjectilePool;
+
+// Context fields read by the companion tree nodes, used as their read masks for reactive ticking
+namespace CompanionField
+{
+	enum : uint32_t
+	{
+		Order			= 1 << 0,
+		Transform		= 1 << 1,
+		PlayerPos		= 1 << 2,
+		HealingStation	= 1 << 3,
+		Enemy			= 1 << 4,
+		NoShooting		= 1 << 5,
+		HasPickedUp		= 1 << 6,
+		HasWokenUp		= 1 << 7,
+		TurretTimer		= 1 << 8,
+		TurretCooldown	= 1 << 9,
+		ShootTimer		= 1 << 10,
+		HealCooldown	= 1 << 11,
+
+		All				= ~0u
+	};
+}
+
+// What the companion senses about the world, written by Companion every update and read by the tree nodes
+namespace CompanionKey
+{
+	struct Transform		{ using Type = DreamEngine::Transform;		static constexpr uint32_t ourField = CompanionField::Transform; };
+	struct PlayerPos		{ using Type = DreamEngine::Vector3f;		static constexpr uint32_t ourField = CompanionField::PlayerPos; };
+	struct HealingStation	{ using Type = DreamEngine::Vector3f;		static constexpr uint32_t ourField = CompanionField::HealingStation; };
+	struct EnemyPosition	{ using Type = DreamEngine::Vector3f;		static constexpr uint32_t ourField = CompanionField::Enemy; };
+	struct EnemyTransform	{ using Type = DreamEngine::Transform*;		static constexpr uint32_t ourField = CompanionField::Enemy; };
+	struct SeesEnemy		{ using Type = bool;						static constexpr uint32_t ourField = CompanionField::Enemy; };
+}
+
+template <>
+struct BlackboardEqual<DreamEngine::Vector3f>
+{
+	static bool Equal(const DreamEngine::Vector3f& aFirst, const DreamEngine::Vector3f& aSecond)
+	{
+		return aFirst.x == aSecond.x && aFirst.y == aSecond.y && aFirst.z == aSecond.z;
+	}
+};
+
+// Only position and rotation are compared, nothing reads the scale
+template <>
+struct BlackboardEqual<DreamEngine::Transform>
+{
+	static bool Equal(const DreamEngine::Transform& aFirst, const DreamEngine::Transform& aSecond)
+	{
+		return BlackboardEqual<DreamEngine::Vector3f>::Equal(aFirst.GetPosition(), aSecond.GetPosition()) &&
+			BlackboardEqual<DreamEngine::Vector3f>::Equal(aFirst.GetRotation(), aSecond.GetRotation());
+	}
+};
+
+using CompanionBlackboard = Blackboard<
+	CompanionKey::Transform,
+	CompanionKey::PlayerPos,
+	CompanionKey::HealingStation,
+	CompanionKey::EnemyPosition,
+	CompanionKey::EnemyTransform,
+	CompanionKey::SeesEnemy>;
+
+// State owned by the companion's behaviour
 struct CompanionContext
 {
 	std::shared_ptr<DreamEngine::ModelInstance> modelInstance;
 	std::shared_ptr<DreamEngine::ModelInstance> modelInstanceHealthPack;
-	DreamEngine::Transform transform;
-	DreamEngine::Transform* enemyTransform;
 
-	CU::CountupTimer turretTimer;
-	CU::CountupTimer shootTimer;
-	CU::CountupTimer turretCooldown;
-	CU::CountupTimer healCooldown;
-	CU::CountupTimer conversationTimer;
+	// Timers in the behaviour's TimerWheel, expiring ones mark their CompanionField changed
+	TimerHandle turretTimer;
+	TimerHandle shootTimer;
+	TimerHandle turretCooldown;
+	TimerHandle healCooldown;
+	TimerHandle conversationTimer;
 
 	DreamEngine::Vector3f targetPosition = 0.0f;
-	DreamEngine::Vector3f playerPos = 0.0f;
-	DreamEngine::Vector3f closesHealingStation = 0.0f;
-	DreamEngine::Vector3f enemyPosition = 0.0f;
 	DreamEngine::Vector3f turretPosition = 0.0f;
 	DreamEngine::Vector3f introPosition = 0.0f;
 
@@ -31,7 +91,6 @@ struct CompanionContext
 
 	bool hasPickedUp;
 	bool noShooting = true;
-	bool seesEnemy = false;
 	bool hasSentCoolDownMSG = false;
 	bool hasHealingCoolDown = true;
 	bool hasWokenUp = false;
@@ -0,0 +1,141 @@
+#include "CompanionContextMap.h"
+
+#include "CompanionLanes.h"
+
+#include <cmath>
+
+namespace
+{
+	// Danger is spread over the slots within about 60 degrees of the obstacle, fading to none at the edge
+	constexpr float dangerSpreadCos = 0.5f;
+	// Slots this much more dangerous than the safest slot are masked out
+	constexpr float dangerTolerance = 0.1f;
+
+	static_assert(CompanionContextMap::slotCount % VectorLanes::width == 0, "Slots have to fill whole lanes");
+
+	// Fibonacci sphere: slot i sits at height 1 - (2i + 1) / n, turned the golden angle from the one before
+	struct SlotDirections
+	{
+		alignas(64) float x[CompanionContextMap::slotCount];
+		alignas(64) float y[CompanionContextMap::slotCount];
+		alignas(64) float z[CompanionContextMap::slotCount];
+		alignas(64) float index[CompanionContextMap::slotCount];
+
+		SlotDirections()
+		{
+			const float goldenAngle = 3.14159265f * (3.0f - std::sqrt(5.0f));
+			for (size_t i = 0; i < CompanionContextMap::slotCount; ++i)
+			{
+				float height = 1.0f - (2.0f * i + 1.0f) / CompanionContextMap::slotCount;
+				float radius = std::sqrt(1.0f - height * height);
+				float angle = goldenAngle * i;
+				x[i] = std::cos(angle) * radius;
+				y[i] = height;
+				z[i] = std::sin(angle) * radius;
+				index[i] = static_cast<float>(i);
+			}
+		}
+	};
+
+	const SlotDirections ourSlots;
+
+	template <class Lanes>
+	Lanes DotWithSlots(size_t aSlot, Lanes anX, Lanes aY, Lanes aZ)
+	{
+		return Lanes::Load(&ourSlots.x[aSlot]) * anX + Lanes::Load(&ourSlots.y[aSlot]) * aY + Lanes::Load(&ourSlots.z[aSlot]) * aZ;
+	}
+}
+
+void CompanionContextMap::Clear()
+{
+	for (size_t i = 0; i < slotCount; ++i)
+	{
+		myInterest[i] = 0.0f;
+		myDanger[i] = 0.0f;
+	}
+}
+
+void CompanionContextMap::AddInterest(const DE::Vector3f& aDirection, float aWeight)
+{
+	const VectorLanes x = VectorLanes::Broadcast(aDirection.x);
+	const VectorLanes y = VectorLanes::Broadcast(aDirection.y);
+	const VectorLanes z = VectorLanes::Broadcast(aDirection.z);
+	const VectorLanes halfWeight = VectorLanes::Broadcast(aWeight * 0.5f);
+
+	// (dot + 1) / 2 rather than clamping at zero, so when everything ahead is dangerous turning sideways
+	// still beats turning back
+	for (size_t i = 0; i < slotCount; i += VectorLanes::width)
+	{
+		VectorLanes interest = VectorLanes::Load(&myInterest[i]);
+		VectorLanes dot = DotWithSlots(i, x, y, z);
+		(interest + (dot + VectorLanes::Broadcast(1.0f)) * halfWeight).Store(&myInterest[i]);
+	}
+}
+
+void CompanionContextMap::AddDanger(const DE::Vector3f& aDirection, float aStrength)
+{
+	const VectorLanes x = VectorLanes::Broadcast(aDirection.x);
+	const VectorLanes y = VectorLanes::Broadcast(aDirection.y);
+	const VectorLanes z = VectorLanes::Broadcast(aDirection.z);
+	const VectorLanes zero = VectorLanes::Broadcast(0.0f);
+	const VectorLanes spreadCos = VectorLanes::Broadcast(dangerSpreadCos);
+	const VectorLanes scale = VectorLanes::Broadcast(aStrength / (1.0f - dangerSpreadCos));
+
+	for (size_t i = 0; i < slotCount; i += VectorLanes::width)
+	{
+		VectorLanes danger = Max(zero, DotWithSlots(i, x, y, z) - spreadCos) * scale;
+		Max(VectorLanes::Load(&myDanger[i]), danger).Store(&myDanger[i]);
+	}
+}
+
+DE::Vector3f CompanionContextMap::GetBestDirection() const
+{
+	float lanes[VectorLanes::width];
+
+	// Safest slot first, then the most interesting slot within the tolerance of it
+	VectorLanes minDanger = VectorLanes::Load(&myDanger[0]);
+	for (size_t i = VectorLanes::width; i < slotCount; i += VectorLanes::width)
+		minDanger = Min(minDanger, VectorLanes::Load(&myDanger[i]));
+
+	minDanger.Store(lanes);
+	float safest = lanes[0];
+	for (size_t lane = 1; lane < VectorLanes::width; ++lane)
+		safest = std::fmin(safest, lanes[lane]);
+
+	const VectorLanes dangerLimit = VectorLanes::Broadcast(safest + dangerTolerance);
+	const VectorLanes masked = VectorLanes::Broadcast(-1.0f);
+	VectorLanes bestInterest = masked;
+	VectorLanes bestSlot = VectorLanes::Broadcast(0.0f);
+	for (size_t i = 0; i < slotCount; i += VectorLanes::width)
+	{
+		VectorLanes interest = Select(Greater(VectorLanes::Load(&myDanger[i]), dangerLimit), masked, VectorLanes::Load(&myInterest[i]));
+		VectorLanes::Mask isBetter = Greater(interest, bestInterest);
+		bestInterest = Select(isBetter, interest, bestInterest);
+		bestSlot = Select(isBetter, VectorLanes::Load(&ourSlots.index[i]), bestSlot);
+	}
+
+	float slots[VectorLanes::width];
+	bestInterest.Store(lanes);
+	bestSlot.Store(slots);
+	size_t best = 0;
+	for (size_t lane = 1; lane < VectorLanes::width; ++lane)
+	{
+		if (lanes[lane] > lanes[best])
+			best = lane;
+	}
+
+	return GetSlotDirection(static_cast<size_t>(slots[best]));
+}
+
+float CompanionContextMap::GetMaxDanger() const
+{
+	float maxDanger = 0.0f;
+	for (size_t i = 0; i < slotCount; ++i)
+		maxDanger = std::fmax(maxDanger, myDanger[i]);
+	return maxDanger;
+}
+
+DE::Vector3f CompanionContextMap::GetSlotDirection(size_t aSlot)
+{
+	return DE::Vector3f(ourSlots.x[aSlot], ourSlots.y[aSlot], ourSlots.z[aSlot]);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <DreamEngine/math/Vector3.h>
+
+#include <cstddef>
+
+// Context steering: rather than adding up forces, every update rates a fixed set of directions around the
+// companion. Whatever the companion wants writes interest into the slots facing it, every obstacle writes
+// danger into the slots facing it, and GetBestDirection picks the most interesting of the least dangerous
+// slots. Slots are kept as one array per component so the whole map is rated a few lanes at a time.
+class CompanionContextMap
+{
+public:
+	// Directions spread evenly over the sphere, a multiple of the widest lanes
+	static constexpr size_t slotCount = 32;
+
+	CompanionContextMap() { Clear(); }
+
+	void Clear();
+
+	// Interest in unit aDirection, full for the slot facing it and falling off to none for the slot facing away
+	void AddInterest(const DE::Vector3f& aDirection, float aWeight = 1.0f);
+	// Danger of an obstacle in unit aDirection, aStrength from 0 far away to 1 touching. A slot keeps the
+	// strongest danger written to it rather than the sum, so one wall seen by two probes stays one wall.
+	void AddDanger(const DE::Vector3f& aDirection, float aStrength);
+
+	// Unit direction of the best slot, slots more dangerous than the safest one by more than a small margin
+	// are never picked however interesting they are
+	DE::Vector3f GetBestDirection() const;
+	// Highest danger written anywhere, 0 when nothing is close
+	float GetMaxDanger() const;
+
+	static DE::Vector3f GetSlotDirection(size_t aSlot);
+
+private:
+	alignas(64) float myInterest[slotCount];
+	alignas(64) float myDanger[slotCount];
+};
@@ -0,0 +1,309 @@
+#include "CompanionDistanceField.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	constexpr char magic[4] = { 'C', 'S', 'D', 'F' };
+	constexpr float quantizationSteps = 32767.0f;
+
+	struct Header
+	{
+		char magic[4];
+		uint16_t version;
+		uint16_t padding;
+		float min[3];
+		float cellSize;
+		float band;
+		uint32_t brickCount[3];
+		uint32_t storedBrickCount;
+	};
+
+	DE::Vector3f ClosestPointOnTriangle(const DE::Vector3f& aPoint, const DE::Vector3f& a, const DE::Vector3f& b, const DE::Vector3f& c)
+	{
+		// Works out which vertex, edge or the face is closest from the barycentric coordinates, as in
+		// Ericson's Real-Time Collision Detection
+		DE::Vector3f ab = b - a;
+		DE::Vector3f ac = c - a;
+		DE::Vector3f ap = aPoint - a;
+		float d1 = ab.Dot(ap);
+		float d2 = ac.Dot(ap);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+			return a;
+
+		DE::Vector3f bp = aPoint - b;
+		float d3 = ab.Dot(bp);
+		float d4 = ac.Dot(bp);
+		if (d3 >= 0.0f && d4 <= d3)
+			return b;
+
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return a + ab * (d1 / (d1 - d3));
+
+		DE::Vector3f cp = aPoint - c;
+		float d5 = ab.Dot(cp);
+		float d6 = ac.Dot(cp);
+		if (d6 >= 0.0f && d5 <= d6)
+			return c;
+
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return a + ac * (d2 / (d2 - d6));
+
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+		float denominator = 1.0f / (va + vb + vc);
+		return a + ab * (vb * denominator) + ac * (vc * denominator);
+	}
+}
+
+template <class IsNear, class Distance>
+void CompanionDistanceField::Bake(const DE::Vector3f& aMin, const DE::Vector3f& aMax, float aCellSize, float aBand, IsNear&& anIsNear, Distance&& aDistance)
+{
+	Clear();
+	myMin = aMin;
+	myCellSize = aCellSize;
+	myBand = aBand;
+
+	float brickSize = aCellSize * brickCells;
+	DE::Vector3f size = aMax - aMin;
+	myBrickCountX = std::max(1, static_cast<int>(std::ceil(size.x / brickSize)));
+	myBrickCountY = std::max(1, static_cast<int>(std::ceil(size.y / brickSize)));
+	myBrickCountZ = std::max(1, static_cast<int>(std::ceil(size.z / brickSize)));
+	myGrid.assign(static_cast<size_t>(myBrickCountX) * myBrickCountY * myBrickCountZ, -1);
+
+	float brickRadius = 0.5f * brickSize * std::sqrt(3.0f);
+	std::vector<int16_t> samples(samplesPerBrick);
+
+	for (int z = 0; z < myBrickCountZ; z++)
+		for (int y = 0; y < myBrickCountY; y++)
+			for (int x = 0; x < myBrickCountX; x++)
+			{
+				DE::Vector3f corner = aMin + DE::Vector3f(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) * brickSize;
+				if (!anIsNear(corner + DE::Vector3f(0.5f * brickSize, 0.5f * brickSize, 0.5f * brickSize), brickRadius))
+					continue;
+
+				bool hasSurface = false;
+				size_t sample = 0;
+				for (int sz = 0; sz < samplesPerSide; sz++)
+					for (int sy = 0; sy < samplesPerSide; sy++)
+						for (int sx = 0; sx < samplesPerSide; sx++)
+						{
+							DE::Vector3f point = corner + DE::Vector3f(static_cast<float>(sx), static_cast<float>(sy), static_cast<float>(sz)) * aCellSize;
+							float distance = std::clamp(aDistance(point), -aBand, aBand);
+							hasSurface |= std::abs(distance) < aBand;
+							samples[sample++] = static_cast<int16_t>(std::lround(distance / aBand * quantizationSteps));
+						}
+
+				if (!hasSurface)
+					continue;
+
+				GetBrickIndex(x, y, z) = static_cast<int32_t>(GetBrickCount());
+				myBricks.insert(myBricks.end(), samples.begin(), samples.end());
+			}
+}
+
+void CompanionDistanceField::Build(const DistanceFunction& aDistance, const DE::Vector3f& aMin, const DE::Vector3f& aMax, float aCellSize, float aBand)
+{
+	Bake(aMin, aMax, aCellSize, aBand,
+		[&aDistance, aBand](const DE::Vector3f& aCenter, float aRadius) { return std::abs(aDistance(aCenter)) - aRadius <= aBand; },
+		aDistance);
+}
+
+void CompanionDistanceField::BuildFromTriangles(const std::vector<DE::Vector3f>& someVertices, const std::vector<uint32_t>& someIndices, float aCellSize, float aBand)
+{
+	Clear();
+	if (someVertices.empty() || someIndices.size() < 3)
+		return;
+
+	struct Triangle
+	{
+		DE::Vector3f a, b, c;
+		DE::Vector3f min, max;
+	};
+
+	std::vector<Triangle> triangles;
+	DE::Vector3f min = someVertices[someIndices[0]];
+	DE::Vector3f max = min;
+	for (size_t i = 0; i + 2 < someIndices.size(); i += 3)
+	{
+		Triangle triangle = { someVertices[someIndices[i]], someVertices[someIndices[i + 1]], someVertices[someIndices[i + 2]] };
+		triangle.min = DE::Vector3f(std::min({ triangle.a.x, triangle.b.x, triangle.c.x }), std::min({ triangle.a.y, triangle.b.y, triangle.c.y }), std::min({ triangle.a.z, triangle.b.z, triangle.c.z }));
+		triangle.max = DE::Vector3f(std::max({ triangle.a.x, triangle.b.x, triangle.c.x }), std::max({ triangle.a.y, triangle.b.y, triangle.c.y }), std::max({ triangle.a.z, triangle.b.z, triangle.c.z }));
+		min = DE::Vector3f(std::min(min.x, triangle.min.x), std::min(min.y, triangle.min.y), std::min(min.z, triangle.min.z));
+		max = DE::Vector3f(std::max(max.x, triangle.max.x), std::max(max.y, triangle.max.y), std::max(max.z, triangle.max.z));
+		triangles.push_back(triangle);
+	}
+
+	// Every brick only measures against the triangles that can come within the band of it
+	std::vector<const Triangle*> nearTriangles;
+	auto isNear = [&](const DE::Vector3f& aCenter, float aRadius)
+		{
+			nearTriangles.clear();
+			float reach = aRadius + aBand;
+			for (const Triangle& triangle : triangles)
+			{
+				if (aCenter.x + reach >= triangle.min.x && aCenter.x - reach <= triangle.max.x &&
+					aCenter.y + reach >= triangle.min.y && aCenter.y - reach <= triangle.max.y &&
+					aCenter.z + reach >= triangle.min.z && aCenter.z - reach <= triangle.max.z)
+					nearTriangles.push_back(&triangle);
+			}
+			return !nearTriangles.empty();
+		};
+
+	auto distance = [&nearTriangles](const DE::Vector3f& aPoint)
+		{
+			float closest = std::numeric_limits<float>::max();
+			for (const Triangle* triangle : nearTriangles)
+				closest = std::min(closest, (aPoint - ClosestPointOnTriangle(aPoint, triangle->a, triangle->b, triangle->c)).LengthSqr());
+			return std::sqrt(closest);
+		};
+
+	DE::Vector3f margin(aBand, aBand, aBand);
+	Bake(min - margin, max + margin, aCellSize, aBand, isNear, distance);
+}
+
+bool CompanionDistanceField::Sample(const DE::Vector3f& aPosition, float& aDistance, DE::Vector3f& aGradient) const
+{
+	aDistance = myBand;
+	aGradient = DE::Vector3f(0.0f);
+	if (myBricks.empty())
+		return false;
+
+	DE::Vector3f cell = (aPosition - myMin) / myCellSize;
+	if (!(cell.x >= 0.0f && cell.y >= 0.0f && cell.z >= 0.0f) ||
+		cell.x >= static_cast<float>(myBrickCountX * brickCells) ||
+		cell.y >= static_cast<float>(myBrickCountY * brickCells) ||
+		cell.z >= static_cast<float>(myBrickCountZ * brickCells))
+		return false;
+
+	int brickX = std::min(static_cast<int>(cell.x) / brickCells, myBrickCountX - 1);
+	int brickY = std::min(static_cast<int>(cell.y) / brickCells, myBrickCountY - 1);
+	int brickZ = std::min(static_cast<int>(cell.z) / brickCells, myBrickCountZ - 1);
+
+	int32_t brick = GetBrickIndex(brickX, brickY, brickZ);
+	if (brick < 0)
+		return false;
+
+	// Corner samples of the cell aPosition is in, every brick holds its own far faces so this never leaves it
+	float localX = cell.x - static_cast<float>(brickX * brickCells);
+	float localY = cell.y - static_cast<float>(brickY * brickCells);
+	float localZ = cell.z - static_cast<float>(brickZ * brickCells);
+	int x = std::min(static_cast<int>(localX), brickCells - 1);
+	int y = std::min(static_cast<int>(localY), brickCells - 1);
+	int z = std::min(static_cast<int>(localZ), brickCells - 1);
+	float fx = localX - static_cast<float>(x);
+	float fy = localY - static_cast<float>(y);
+	float fz = localZ - static_cast<float>(z);
+
+	const int16_t* samples = myBricks.data() + static_cast<size_t>(brick) * samplesPerBrick;
+	auto at = [samples, this](int aX, int aY, int aZ)
+		{
+			return static_cast<float>(samples[(aZ * samplesPerSide + aY) * samplesPerSide + aX]) / quantizationSteps * myBand;
+		};
+	float d000 = at(x, y, z), d100 = at(x + 1, y, z), d010 = at(x, y + 1, z), d110 = at(x + 1, y + 1, z);
+	float d001 = at(x, y, z + 1), d101 = at(x + 1, y, z + 1), d011 = at(x, y + 1, z + 1), d111 = at(x + 1, y + 1, z + 1);
+
+	// Trilinear blend, and its derivative along each axis for the gradient
+	float d00 = d000 + (d100 - d000) * fx;
+	float d10 = d010 + (d110 - d010) * fx;
+	float d01 = d001 + (d101 - d001) * fx;
+	float d11 = d011 + (d111 - d011) * fx;
+	float d0 = d00 + (d10 - d00) * fy;
+	float d1 = d01 + (d11 - d01) * fy;
+	aDistance = d0 + (d1 - d0) * fz;
+
+	float dx0 = (d100 - d000) + ((d110 - d010) - (d100 - d000)) * fy;
+	float dx1 = (d101 - d001) + ((d111 - d011) - (d101 - d001)) * fy;
+	aGradient.x = dx0 + (dx1 - dx0) * fz;
+	aGradient.y = (d10 - d00) + ((d11 - d01) - (d10 - d00)) * fz;
+	aGradient.z = d1 - d0;
+	aGradient = aGradient.GetNormalized();
+
+	return aDistance < myBand;
+}
+
+size_t CompanionDistanceField::GetByteCount() const
+{
+	return sizeof(Header) + myGrid.size() * sizeof(int32_t) + myBricks.size() * sizeof(int16_t);
+}
+
+void CompanionDistanceField::Save(std::vector<uint8_t>& aBinary) const
+{
+	Header header = {};
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = ourVersion;
+	header.min[0] = myMin.x;
+	header.min[1] = myMin.y;
+	header.min[2] = myMin.z;
+	header.cellSize = myCellSize;
+	header.band = myBand;
+	header.brickCount[0] = static_cast<uint32_t>(myBrickCountX);
+	header.brickCount[1] = static_cast<uint32_t>(myBrickCountY);
+	header.brickCount[2] = static_cast<uint32_t>(myBrickCountZ);
+	header.storedBrickCount = static_cast<uint32_t>(GetBrickCount());
+
+	aBinary.resize(GetByteCount());
+	uint8_t* write = aBinary.data();
+	std::memcpy(write, &header, sizeof(header));
+	write += sizeof(header);
+	std::memcpy(write, myGrid.data(), myGrid.size() * sizeof(int32_t));
+	write += myGrid.size() * sizeof(int32_t);
+	std::memcpy(write, myBricks.data(), myBricks.size() * sizeof(int16_t));
+}
+
+bool CompanionDistanceField::Load(const void* someData, size_t aByteCount)
+{
+	Clear();
+
+	Header header;
+	if (aByteCount < sizeof(header))
+		return false;
+	std::memcpy(&header, someData, sizeof(header));
+	if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != ourVersion)
+		return false;
+	if (!(header.cellSize > 0.0f) || !(header.band > 0.0f))
+		return false;
+
+	size_t gridSize = static_cast<size_t>(header.brickCount[0]) * header.brickCount[1] * header.brickCount[2];
+	size_t brickSize = static_cast<size_t>(header.storedBrickCount) * samplesPerBrick;
+	if (aByteCount != sizeof(header) + gridSize * sizeof(int32_t) + brickSize * sizeof(int16_t))
+		return false;
+
+	const uint8_t* read = static_cast<const uint8_t*>(someData) + sizeof(header);
+	std::vector<int32_t> grid(gridSize);
+	std::memcpy(grid.data(), read, gridSize * sizeof(int32_t));
+	read += gridSize * sizeof(int32_t);
+
+	for (int32_t brick : grid)
+	{
+		if (brick < -1 || brick >= static_cast<int32_t>(header.storedBrickCount))
+			return false;
+	}
+
+	myMin = DE::Vector3f(header.min[0], header.min[1], header.min[2]);
+	myCellSize = header.cellSize;
+	myBand = header.band;
+	myBrickCountX = static_cast<int>(header.brickCount[0]);
+	myBrickCountY = static_cast<int>(header.brickCount[1]);
+	myBrickCountZ = static_cast<int>(header.brickCount[2]);
+	myGrid = std::move(grid);
+	myBricks.resize(brickSize);
+	std::memcpy(myBricks.data(), read, brickSize * sizeof(int16_t));
+	return true;
+}
+
+void CompanionDistanceField::Clear()
+{
+	myGrid.clear();
+	myBricks.clear();
+	myBrickCountX = 0;
+	myBrickCountY = 0;
+	myBrickCountZ = 0;
+}
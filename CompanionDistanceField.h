@@ -0,0 +1,68 @@
+#pragma once
+#include <DreamEngine/math/Vector3.h>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Distance from any point to the closest static environment surface, baked ahead of time so avoidance can
+// look it up instead of raycasting. The field is a grid of bricks of brickCells cells a side, and only the
+// bricks within the band of a surface are stored. Everything further away reads as out of range. Bake it
+// from a distance function, such as HeadlessCompanionWorld::GetStaticDistance, or from level triangles, then
+// keep the bytes from Save and Load them with the level.
+//
+// Saved layout, native little endian after the magic:
+//   header   "CSDF", uint16 version, float min x/y/z, cell size, band, uint32 bricks x/y/z, uint32 brick count
+//   grid     int32 brick index per brick position, x fastest, -1 where nothing is stored
+//   bricks   int16 distance per corner of every cell, (brickCells + 1)^3 per brick, in 1/32767ths of the band
+class CompanionDistanceField
+{
+public:
+	static constexpr uint16_t ourVersion = 1;
+	static constexpr int brickCells = 8;
+
+	// Signed distance from a point to the environment, negative inside. It must never be more than the true
+	// distance, bricks are skipped on it.
+	using DistanceFunction = std::function<float(const DE::Vector3f&)>;
+
+	// Bakes the field over aMin to aMax with cells aCellSize wide, keeping distances up to aBand
+	void Build(const DistanceFunction& aDistance, const DE::Vector3f& aMin, const DE::Vector3f& aMax, float aCellSize, float aBand);
+	// Bakes from a triangle list of level geometry, three indices per triangle. Triangles have no inside, so
+	// these distances are never negative.
+	void BuildFromTriangles(const std::vector<DE::Vector3f>& someVertices, const std::vector<uint32_t>& someIndices, float aCellSize, float aBand);
+
+	// Distance to the closest surface at aPosition, and the direction away from it. Returns false when there
+	// is no surface within the band, or aPosition is outside the field.
+	bool Sample(const DE::Vector3f& aPosition, float& aDistance, DE::Vector3f& aGradient) const;
+
+	bool IsEmpty() const { return myBricks.empty(); }
+	size_t GetBrickCount() const { return myBricks.size() / samplesPerBrick; }
+	float GetBand() const { return myBand; }
+	// Bytes the baked field takes, as saved
+	size_t GetByteCount() const;
+
+	void Save(std::vector<uint8_t>& aBinary) const;
+	// Checks the header and sizes up front, the field is left empty if this returns false
+	bool Load(const void* someData, size_t aByteCount);
+
+private:
+	static constexpr int samplesPerSide = brickCells + 1;
+	static constexpr size_t samplesPerBrick = samplesPerSide * samplesPerSide * samplesPerSide;
+
+	// Bakes every brick anIsNear(center, radius) says may be within the band of a surface, sampling aDistance
+	template <class IsNear, class Distance>
+	void Bake(const DE::Vector3f& aMin, const DE::Vector3f& aMax, float aCellSize, float aBand, IsNear&& anIsNear, Distance&& aDistance);
+	void Clear();
+	int32_t& GetBrickIndex(int anX, int aY, int aZ) { return myGrid[(static_cast<size_t>(aZ) * myBrickCountY + aY) * myBrickCountX + anX]; }
+	int32_t GetBrickIndex(int anX, int aY, int aZ) const { return myGrid[(static_cast<size_t>(aZ) * myBrickCountY + aY) * myBrickCountX + anX]; }
+
+	DE::Vector3f myMin;
+	float myCellSize = 1.0f;
+	float myBand = 0.0f;
+	int myBrickCountX = 0;
+	int myBrickCountY = 0;
+	int myBrickCountZ = 0;
+
+	std::vector<int32_t> myGrid;
+	std::vector<int16_t> myBricks;
+};
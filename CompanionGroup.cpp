@@ -0,0 +1,152 @@
+#include "CompanionGroup.h"
+#include "Companion.h"
+#include "JobSystem.h"
+#include "CompanionWorld.h"
+#include "CompanionAllocations.h"
+
+#include <algorithm>
+
+namespace
+{
+	constexpr size_t companionsPerJob = 4;
+}
+
+CompanionGroup::CompanionGroup(JobSystem& aJobSystem): myJobSystem(aJobSystem)
+{}
+
+CompanionGroup::~CompanionGroup()
+{
+	for (Companion* companion : myCompanions)
+	{
+		companion->SetGroup(nullptr);
+		companion->GetBehavior().SetCommandBuffer(nullptr);
+		companion->GetBehavior().SetTimerWheel(nullptr);
+	}
+}
+
+void CompanionGroup::Add(Companion* aCompanion)
+{
+	aCompanion->SetGroup(this);
+	aCompanion->GetBehavior().SetCommandBuffer(&myCommands);
+	aCompanion->GetBehavior().SetTimerWheel(&myTimers);
+	myCompanions.push_back(aCompanion);
+	myBehaviors.push_back(&aCompanion->GetBehavior());
+	myScheduler.Add();
+
+	// Room for every companion being due at once, so a frame never grows these
+	myDueCompanions.reserve(myCompanions.size());
+	myDueBehaviors.reserve(myCompanions.size());
+	myRaycasts.Reserve(myCompanions.size() * static_cast<size_t>(eProbe::count));
+	mySteering.Reserve(myCompanions.size());
+}
+
+void CompanionGroup::Remove(Companion* aCompanion)
+{
+	auto it = std::find(myCompanions.begin(), myCompanions.end(), aCompanion);
+	if (it == myCompanions.end())
+		return;
+
+	size_t index = it - myCompanions.begin();
+	myBehaviors.erase(myBehaviors.begin() + index);
+	myScheduler.Remove(index);
+	myCompanions.erase(it);
+	aCompanion->SetGroup(nullptr);
+	aCompanion->GetBehavior().SetCommandBuffer(nullptr);
+	aCompanion->GetBehavior().SetTimerWheel(nullptr);
+}
+
+void CompanionGroup::Save(std::vector<Companion::Snapshot>& someSnapshots) const
+{
+	someSnapshots.resize(myCompanions.size());
+	for (size_t i = 0; i < myCompanions.size(); i++)
+		myCompanions[i]->Save(someSnapshots[i]);
+}
+
+void CompanionGroup::Restore(const std::vector<Companion::Snapshot>& someSnapshots)
+{
+	assert(someSnapshots.size() == myCompanions.size() && "Snapshots were saved from a different group");
+	for (size_t i = 0; i < myCompanions.size(); i++)
+		myCompanions[i]->Restore(someSnapshots[i]);
+}
+
+void CompanionGroup::Update(float aDeltaTime)
+{
+	if (CompanionWorld::Get().IsPaused())
+		return;
+
+	// Everything up to the flush, which plays the frame back into the engine, runs without allocating once warmed up
+	{
+		CompanionAllocations::FrameCheck allocationCheck(myUpdateCount++);
+		UpdateDueCompanions(aDeltaTime);
+	}
+
+	myCommands.Flush();
+	for (size_t index : myDueCompanions)
+		myCompanions[index]->Act();
+
+	for (size_t i = 0; i < myCompanions.size(); i++)
+		myCompanions[i]->Interpolate(myScheduler.GetInterpolation(i));
+}
+
+void CompanionGroup::UpdateDueCompanions(float aDeltaTime)
+{
+	// Timers run on frame time whatever rate each companion is updated at, expiries are seen on its next update
+	myTimers.Advance(aDeltaTime);
+
+	DE::Vector3f viewPosition = CompanionWorld::Get().GetCameraTransform().GetPosition();
+
+	myScheduler.BeginFrame(aDeltaTime);
+	myDueCompanions.clear();
+	myDueBehaviors.clear();
+	for (size_t i = 0; i < myCompanions.size(); i++)
+	{
+		float distance = (myCompanions[i]->GetTransform()->GetPosition() - viewPosition).Length();
+		if (myScheduler.Schedule(i, distance))
+		{
+			myDueCompanions.push_back(i);
+			myDueBehaviors.push_back(myBehaviors[i]);
+		}
+	}
+
+	myJobSystem.ParallelFor(myDueCompanions.size(), companionsPerJob, [this](size_t aFirst, size_t aLast)
+		{
+			for (size_t i = aFirst; i < aLast; i++)
+			{
+				Companion* companion = myCompanions[myDueCompanions[i]];
+				if (myTargetGrid != nullptr)
+					companion->SetTargetedEnemy(*myTargetGrid);
+				companion->Sense();
+			}
+		});
+
+	// Thinking records its side effects into myCommands, but still reads input and swaps textures, so it stays on this thread
+	CompanionBehavior::UpdateTrees(myDueBehaviors, myBatch);
+	for (size_t index : myDueCompanions)
+		myCompanions[index]->Think(myScheduler.GetDeltaTime(index));
+
+	// Every raycast steering needs this frame is cast in one batch, before any companion steers
+	myRaycasts.Clear();
+	for (size_t index : myDueCompanions)
+		myCompanions[index]->QueueProbes(myRaycasts);
+	myRaycasts.Submit(CompanionWorld::Get(), &myJobSystem);
+
+	// Probing and targets per companion, the steering maths for all of them at once, then rotation per companion
+	mySteering.Resize(myDueCompanions.size());
+	myJobSystem.ParallelFor(myDueCompanions.size(), companionsPerJob, [this](size_t aFirst, size_t aLast)
+		{
+			for (size_t i = aFirst; i < aLast; i++)
+			{
+				size_t index = myDueCompanions[i];
+				myCompanions[index]->BeginSteer(myScheduler.GetDeltaTime(index), mySteering, i);
+			}
+		});
+	mySteering.Update();
+	myJobSystem.ParallelFor(myDueCompanions.size(), companionsPerJob, [this](size_t aFirst, size_t aLast)
+		{
+			for (size_t i = aFirst; i < aLast; i++)
+			{
+				size_t index = myDueCompanions[i];
+				myCompanions[index]->EndSteer(myScheduler.GetDeltaTime(index), mySteering, i);
+			}
+		});
+}
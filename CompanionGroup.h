@@ -0,0 +1,61 @@
+#pragma once
+#include "BehaviourTree.h"
+#include "CompanionCommandBuffer.h"
+#include "CompanionRaycastBatch.h"
+#include "CompanionSteeringBatch.h"
+#include "CompanionScheduler.h"
+#include "TimerWheel.h"
+#include "Companion.h"
+
+#include <vector>
+
+class CompanionBehavior;
+class CompanionTargetGrid;
+class JobSystem;
+
+// Updates many companions phase by phase instead of one companion at a time. Sensing and steering run
+// spread over the job system, the trees are ticked in lockstep, and everything touching PhysX actors or
+// engine systems runs on the calling thread. Companions far from the camera are updated less often, see
+// CompanionScheduler, and drawn interpolated in between. Call Update once per frame from the main thread.
+class CompanionGroup
+{
+public:
+	CompanionGroup(JobSystem& aJobSystem);
+	~CompanionGroup();
+
+	void Add(Companion* aCompanion);
+	void Remove(Companion* aCompanion);
+
+	void Update(float aDeltaTime);
+
+	// One snapshot per companion, in the order they were added
+	void Save(std::vector<Companion::Snapshot>& someSnapshots) const;
+	void Restore(const std::vector<Companion::Snapshot>& someSnapshots);
+
+	// Enemies the companions target, each due companion picks the closest in range before sensing. The grid
+	// has to be synced before Update and left alone during it.
+	void SetTargetGrid(const CompanionTargetGrid* aGrid) { myTargetGrid = aGrid; }
+
+	CompanionScheduler& GetScheduler() { return myScheduler; }
+	TimerWheel& GetTimers() { return myTimers; }
+
+private:
+	// Schedules the companions due this frame and runs them up to their side effects
+	void UpdateDueCompanions(float aDeltaTime);
+
+	JobSystem& myJobSystem;
+	const CompanionTargetGrid* myTargetGrid = nullptr;
+	std::vector<Companion*> myCompanions;
+	std::vector<CompanionBehavior*> myBehaviors;
+	TickBatch myBatch;
+	CompanionCommandBuffer myCommands;
+	CompanionRaycastBatch myRaycasts;
+	CompanionSteeringBatch mySteering;
+	CompanionScheduler myScheduler;
+	TimerWheel myTimers;
+
+	// Companions updated this frame, as indices into myCompanions
+	std::vector<size_t> myDueCompanions;
+	std::vector<CompanionBehavior*> myDueBehaviors;
+	unsigned int myUpdateCount = 0;
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+#if defined(__AVX512F__) || defined(__AVX__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#endif
+
+// Float lanes for the companion's data parallel loops, written once as templates over the lane type.
+// VectorLanes is the widest the build targets: 16 floats with AVX-512, 8 with AVX, 4 with SSE2 and
+// ScalarLanes otherwise. Loads and stores are unaligned.
+
+// One companion at a time, the fallback when there is no vector instruction set
+struct ScalarLanes
+{
+	static constexpr size_t width = 1;
+	using Mask = bool;
+
+	float value;
+
+	static ScalarLanes Load(const float* someValues) { return { *someValues }; }
+	static ScalarLanes Broadcast(float aValue) { return { aValue }; }
+	void Store(float* someValues) const { *someValues = value; }
+
+	friend ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return { a.value + b.value }; }
+	friend ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return { a.value - b.value }; }
+	friend ScalarLanes operator*(ScalarLanes a, ScalarLanes b) { return { a.value * b.value }; }
+	friend ScalarLanes operator/(ScalarLanes a, ScalarLanes b) { return { a.value / b.value }; }
+	friend ScalarLanes Sqrt(ScalarLanes a) { return { std::sqrt(a.value) }; }
+	friend ScalarLanes Max(ScalarLanes a, ScalarLanes b) { return { a.value > b.value ? a.value : b.value }; }
+	friend ScalarLanes Min(ScalarLanes a, ScalarLanes b) { return { a.value < b.value ? a.value : b.value }; }
+	friend Mask Greater(ScalarLanes a, ScalarLanes b) { return a.value > b.value; }
+	friend ScalarLanes Select(Mask aMask, ScalarLanes anIfTrue, ScalarLanes anIfFalse) { return aMask ? anIfTrue : anIfFalse; }
+};
+
+#if defined(__AVX512F__)
+struct VectorLanes
+{
+	static constexpr size_t width = 16;
+	using Mask = __mmask16;
+
+	__m512 value;
+
+	static VectorLanes Load(const float* someValues) { return { _mm512_loadu_ps(someValues) }; }
+	static VectorLanes Broadcast(float aValue) { return { _mm512_set1_ps(aValue) }; }
+	void Store(float* someValues) const { _mm512_storeu_ps(someValues, value); }
+
+	friend VectorLanes operator+(VectorLanes a, VectorLanes b) { return { _mm512_add_ps(a.value, b.value) }; }
+	friend VectorLanes operator-(VectorLanes a, VectorLanes b) { return { _mm512_sub_ps(a.value, b.value) }; }
+	friend VectorLanes operator*(VectorLanes a, VectorLanes b) { return { _mm512_mul_ps(a.value, b.value) }; }
+	friend VectorLanes operator/(VectorLanes a, VectorLanes b) { return { _mm512_div_ps(a.value, b.value) }; }
+	friend VectorLanes Sqrt(VectorLanes a) { return { _mm512_sqrt_ps(a.value) }; }
+	friend VectorLanes Max(VectorLanes a, VectorLanes b) { return { _mm512_max_ps(a.value, b.value) }; }
+	friend VectorLanes Min(VectorLanes a, VectorLanes b) { return { _mm512_min_ps(a.value, b.value) }; }
+	friend Mask Greater(VectorLanes a, VectorLanes b) { return _mm512_cmp_ps_mask(a.value, b.value, _CMP_GT_OQ); }
+	friend VectorLanes Select(Mask aMask, VectorLanes anIfTrue, VectorLanes anIfFalse) { return { _mm512_mask_blend_ps(aMask, anIfFalse.value, anIfTrue.value) }; }
+};
+#elif defined(__AVX__)
+struct VectorLanes
+{
+	static constexpr size_t width = 8;
+	using Mask = __m256;
+
+	__m256 value;
+
+	static VectorLanes Load(const float* someValues) { return { _mm256_loadu_ps(someValues) }; }
+	static VectorLanes Broadcast(float aValue) { return { _mm256_set1_ps(aValue) }; }
+	void Store(float* someValues) const { _mm256_storeu_ps(someValues, value); }
+
+	friend VectorLanes operator+(VectorLanes a, VectorLanes b) { return { _mm256_add_ps(a.value, b.value) }; }
+	friend VectorLanes operator-(VectorLanes a, VectorLanes b) { return { _mm256_sub_ps(a.value, b.value) }; }
+	friend VectorLanes operator*(VectorLanes a, VectorLanes b) { return { _mm256_mul_ps(a.value, b.value) }; }
+	friend VectorLanes operator/(VectorLanes a, VectorLanes b) { return { _mm256_div_ps(a.value, b.value) }; }
+	friend VectorLanes Sqrt(VectorLanes a) { return { _mm256_sqrt_ps(a.value) }; }
+	friend VectorLanes Max(VectorLanes a, VectorLanes b) { return { _mm256_max_ps(a.value, b.value) }; }
+	friend VectorLanes Min(VectorLanes a, VectorLanes b) { return { _mm256_min_ps(a.value, b.value) }; }
+	friend Mask Greater(VectorLanes a, VectorLanes b) { return _mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ); }
+	friend VectorLanes Select(Mask aMask, VectorLanes anIfTrue, VectorLanes anIfFalse) { return { _mm256_blendv_ps(anIfFalse.value, anIfTrue.value, aMask) }; }
+};
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+struct VectorLanes
+{
+	static constexpr size_t width = 4;
+	using Mask = __m128;
+
+	__m128 value;
+
+	static VectorLanes Load(const float* someValues) { return { _mm_loadu_ps(someValues) }; }
+	static VectorLanes Broadcast(float aValue) { return { _mm_set1_ps(aValue) }; }
+	void Store(float* someValues) const { _mm_storeu_ps(someValues, value); }
+
+	friend VectorLanes operator+(VectorLanes a, VectorLanes b) { return { _mm_add_ps(a.value, b.value) }; }
+	friend VectorLanes operator-(VectorLanes a, VectorLanes b) { return { _mm_sub_ps(a.value, b.value) }; }
+	friend VectorLanes operator*(VectorLanes a, VectorLanes b) { return { _mm_mul_ps(a.value, b.value) }; }
+	friend VectorLanes operator/(VectorLanes a, VectorLanes b) { return { _mm_div_ps(a.value, b.value) }; }
+	friend VectorLanes Sqrt(VectorLanes a) { return { _mm_sqrt_ps(a.value) }; }
+	friend VectorLanes Max(VectorLanes a, VectorLanes b) { return { _mm_max_ps(a.value, b.value) }; }
+	friend VectorLanes Min(VectorLanes a, VectorLanes b) { return { _mm_min_ps(a.value, b.value) }; }
+	friend Mask Greater(VectorLanes a, VectorLanes b) { return _mm_cmpgt_ps(a.value, b.value); }
+	friend VectorLanes Select(Mask aMask, VectorLanes anIfTrue, VectorLanes anIfFalse)
+	{
+		return { _mm_or_ps(_mm_and_ps(aMask, anIfTrue.value), _mm_andnot_ps(aMask, anIfFalse.value)) };
+	}
+};
+#else
+using VectorLanes = ScalarLanes;
+#endif
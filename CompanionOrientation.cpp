@@ -0,0 +1,89 @@
+#include "CompanionOrientation.h"
+
+#include <DreamEngine/math/Transform.h>
+
+#include <cmath>
+
+namespace
+{
+	// How far a companion leans towards where it faces
+	constexpr float rotationUpOffset = 0.011f;
+}
+
+CompanionOrientation CompanionOrientation::FromBasis(const DE::Vector3f& aRight, const DE::Vector3f& anUp, const DE::Vector3f& aForward)
+{
+	// The basis vectors are the columns of the rotation matrix, taken apart from its largest diagonal term so
+	// the square root never gets close to zero
+	CompanionOrientation orientation;
+	float trace = aRight.x + anUp.y + aForward.z;
+	if (trace > 0.0f)
+	{
+		float s = 2.0f * std::sqrt(trace + 1.0f);
+		orientation.w = 0.25f * s;
+		orientation.x = (anUp.z - aForward.y) / s;
+		orientation.y = (aForward.x - aRight.z) / s;
+		orientation.z = (aRight.y - anUp.x) / s;
+	}
+	else if (aRight.x > anUp.y && aRight.x > aForward.z)
+	{
+		float s = 2.0f * std::sqrt(1.0f + aRight.x - anUp.y - aForward.z);
+		orientation.w = (anUp.z - aForward.y) / s;
+		orientation.x = 0.25f * s;
+		orientation.y = (anUp.x + aRight.y) / s;
+		orientation.z = (aForward.x + aRight.z) / s;
+	}
+	else if (anUp.y > aForward.z)
+	{
+		float s = 2.0f * std::sqrt(1.0f + anUp.y - aRight.x - aForward.z);
+		orientation.w = (aForward.x - aRight.z) / s;
+		orientation.x = (anUp.x + aRight.y) / s;
+		orientation.y = 0.25f * s;
+		orientation.z = (aForward.y + anUp.z) / s;
+	}
+	else
+	{
+		float s = 2.0f * std::sqrt(1.0f + aForward.z - aRight.x - anUp.y);
+		orientation.w = (aRight.y - anUp.x) / s;
+		orientation.x = (aForward.x + aRight.z) / s;
+		orientation.y = (aForward.y + anUp.z) / s;
+		orientation.z = 0.25f * s;
+	}
+	return orientation;
+}
+
+CompanionOrientation CompanionOrientation::LookRotation(const DE::Vector3f& aDirection)
+{
+	DE::Vector3f up = (DE::Vector3f(0.0f, 1.0f, 0.0f) + aDirection.GetNormalized() * rotationUpOffset).GetNormalized();
+
+	// What is left of world up across the leaning up axis points away from aDirection
+	DE::Vector3f forward = DE::Vector3f(0.0f, 1.0f, 0.0f);
+	forward = (forward - forward.Dot(up) * up).GetNormalized() * -1.0f;
+
+	DE::Vector3f right = up.Cross(forward).GetNormalized();
+	return FromBasis(right, up, forward);
+}
+
+CompanionOrientation CompanionOrientation::Nlerp(const CompanionOrientation& aFrom, const CompanionOrientation& aTo, float aT)
+{
+	// q and -q are the same rotation, blending towards the one closer to aFrom takes the short way around
+	float dot = aFrom.w * aTo.w + aFrom.x * aTo.x + aFrom.y * aTo.y + aFrom.z * aTo.z;
+	float sign = dot < 0.0f ? -1.0f : 1.0f;
+
+	CompanionOrientation blended;
+	blended.w = aFrom.w + (aTo.w * sign - aFrom.w) * aT;
+	blended.x = aFrom.x + (aTo.x * sign - aFrom.x) * aT;
+	blended.y = aFrom.y + (aTo.y * sign - aFrom.y) * aT;
+	blended.z = aFrom.z + (aTo.z * sign - aFrom.z) * aT;
+
+	float length = std::sqrt(blended.w * blended.w + blended.x * blended.x + blended.y * blended.y + blended.z * blended.z);
+	blended.w /= length;
+	blended.x /= length;
+	blended.y /= length;
+	blended.z /= length;
+	return blended;
+}
+
+DE::Vector3f CompanionOrientation::GetEulerAnglesDegrees() const
+{
+	return DE::Quatf(w, x, y, z).GetEulerAnglesDegrees();
+}
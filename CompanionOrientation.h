@@ -0,0 +1,22 @@
+#pragma once
+#include <DreamEngine/math/Vector3.h>
+
+// A companion's rotation as a unit quaternion, which is what it is kept, blended and saved as. Euler angles
+// are only made where a rotation is handed to the engine.
+struct CompanionOrientation
+{
+	float w = 1.0f;
+	float x = 0.0f;
+	float y = 0.0f;
+	float z = 0.0f;
+
+	// The orientation that turns the x, y and z axes onto the given orthonormal right, up and forward
+	static CompanionOrientation FromBasis(const DE::Vector3f& aRight, const DE::Vector3f& anUp, const DE::Vector3f& aForward);
+	// Facing aDirection along the ground, upright with a slight lean towards it
+	static CompanionOrientation LookRotation(const DE::Vector3f& aDirection);
+	// aT of the way from aFrom to aTo along the shorter arc, normalised linear blending so it costs the same for any angle
+	static CompanionOrientation Nlerp(const CompanionOrientation& aFrom, const CompanionOrientation& aTo, float aT);
+
+	// Euler angles in degrees, as transforms and model instances take them
+	DE::Vector3f GetEulerAnglesDegrees() const;
+};
@@ -0,0 +1,47 @@
+#include "CompanionRaycastBatch.h"
+#include "JobSystem.h"
+
+#include <assert.h>
+
+namespace
+{
+	// Enough raycasts per job that handing them out costs less than casting them
+	constexpr size_t raycastsPerJob = 32;
+}
+
+size_t CompanionRaycastBatch::Add(const CompanionWorld::RaycastQuery& aQuery)
+{
+	assert(!myIsSubmitted && "Clear the batch before adding to it again");
+	myQueries.push_back(aQuery);
+	return myQueries.size() - 1;
+}
+
+void CompanionRaycastBatch::Clear()
+{
+	myQueries.clear();
+	myResults.clear();
+	myIsSubmitted = false;
+}
+
+void CompanionRaycastBatch::Reserve(size_t aCount)
+{
+	myQueries.reserve(aCount);
+	myResults.reserve(aCount);
+}
+
+void CompanionRaycastBatch::Submit(CompanionWorld& aWorld, JobSystem* aJobSystem)
+{
+	myResults.resize(myQueries.size());
+	myIsSubmitted = true;
+
+	if (aJobSystem == nullptr || myQueries.size() <= raycastsPerJob)
+	{
+		aWorld.RaycastBatch(myQueries.data(), myResults.data(), myQueries.size());
+		return;
+	}
+
+	aJobSystem->ParallelFor(myQueries.size(), raycastsPerJob, [this, &aWorld](size_t aFirst, size_t aLast)
+		{
+			aWorld.RaycastBatch(myQueries.data() + aFirst, myResults.data() + aFirst, aLast - aFirst);
+		});
+}
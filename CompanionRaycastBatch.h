@@ -0,0 +1,30 @@
+#pragma once
+#include "CompanionWorld.h"
+
+#include <vector>
+
+class JobSystem;
+
+// The environment raycasts of many companions for one frame, collected first and cast together. Queries
+// are added from one thread, then Submit casts them all through the CompanionWorld, spread over the job
+// system when one is given, and the results are read back by index.
+class CompanionRaycastBatch
+{
+public:
+	// Returns the index of the query's result
+	size_t Add(const CompanionWorld::RaycastQuery& aQuery);
+	void Clear();
+	// Makes room for aCount queries up front, so adding them doesn't allocate
+	void Reserve(size_t aCount);
+
+	void Submit(CompanionWorld& aWorld, JobSystem* aJobSystem = nullptr);
+
+	bool IsSubmitted() const { return myIsSubmitted; }
+	size_t GetCount() const { return myQueries.size(); }
+	const CompanionWorld::RaycastResult& GetResult(size_t anIndex) const { return myResults[anIndex]; }
+
+private:
+	std::vector<CompanionWorld::RaycastQuery> myQueries;
+	std::vector<CompanionWorld::RaycastResult> myResults;
+	bool myIsSubmitted = false;
+};
@@ -0,0 +1,50 @@
+#include "CompanionScheduler.h"
+
+#include <algorithm>
+
+void CompanionScheduler::Add()
+{
+	mySlots.push_back({ 0.0f, 0.0f, 0.0f, 0 });
+}
+
+void CompanionScheduler::Remove(size_t anIndex)
+{
+	mySlots.erase(mySlots.begin() + anIndex);
+}
+
+void CompanionScheduler::BeginFrame(float aDeltaTime)
+{
+	myFrame++;
+	myDeltaTime = aDeltaTime;
+}
+
+bool CompanionScheduler::Schedule(size_t anIndex, float aDistance)
+{
+	Slot& slot = mySlots[anIndex];
+
+	slot.level = 0;
+	while (slot.level < ourLevelCount - 1 && aDistance > myLevelDistances[slot.level])
+		slot.level++;
+
+	slot.accumulatedTime += myDeltaTime;
+	slot.timeSinceUpdate += myDeltaTime;
+
+	// The index offsets the frame so companions sharing a rate take turns instead of updating together
+	uint32_t period = 1u << slot.level;
+	if ((myFrame + static_cast<uint32_t>(anIndex)) % period != 0)
+		return false;
+
+	slot.updateTime = slot.accumulatedTime;
+	slot.accumulatedTime = 0.0f;
+	slot.timeSinceUpdate = myDeltaTime;
+	return true;
+}
+
+float CompanionScheduler::GetInterpolation(size_t anIndex) const
+{
+	const Slot& slot = mySlots[anIndex];
+	if (slot.updateTime <= 0.0f)
+		return 1.0f;
+
+	return std::min(1.0f, slot.timeSinceUpdate / slot.updateTime);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Level-of-detail scheduling for companion updates. Each companion gets an update rate from its distance
+// to the viewer, every frame up close and every 2nd, 4th or 8th frame further away. Companions on the
+// same rate are spread evenly over the frames, and the time between two updates is accumulated so the
+// update that does run gets the full delta time.
+class CompanionScheduler
+{
+public:
+	static constexpr int ourLevelCount = 4;
+
+	void Add();
+	void Remove(size_t anIndex);
+
+	// Companions further away than aDistance update every 2^aLevel frames, aLevel is 1 to ourLevelCount - 1
+	void SetLevelDistance(int aLevel, float aDistance) { myLevelDistances[aLevel - 1] = aDistance; }
+
+	// Call once per frame, then Schedule every companion
+	void BeginFrame(float aDeltaTime);
+	bool Schedule(size_t anIndex, float aDistance);
+
+	// Time since the companion's previous update, valid on frames it is scheduled
+	float GetDeltaTime(size_t anIndex) const { return mySlots[anIndex].updateTime; }
+
+	// How far the rendered transform is between the previous and the latest update, 0 to 1
+	float GetInterpolation(size_t anIndex) const;
+
+private:
+	struct Slot
+	{
+		float accumulatedTime;
+		float updateTime;
+		float timeSinceUpdate;
+		uint8_t level;
+	};
+
+	std::array<float, ourLevelCount - 1> myLevelDistances = { 2000.0f, 4000.0f, 8000.0f };
+	std::vector<Slot> mySlots;
+	uint32_t myFrame = 0;
+	float myDeltaTime = 0.0f;
+};
@@ -0,0 +1,142 @@
+#include "CompanionSteeringBatch.h"
+
+#include "CompanionLanes.h"
+
+namespace
+{
+	// Lanes of the widest instruction set supported, every stream is padded to a multiple of it
+	constexpr size_t maxLaneCount = 16;
+
+	// Keeps the direction to a target sitting on the companion finite, such slots are skipped by the behaviour anyway
+	constexpr float minTargetDistance = 1e-6f;
+}
+
+size_t CompanionSteeringBatch::GetLaneCount()
+{
+	return VectorLanes::width;
+}
+
+size_t CompanionSteeringBatch::GetBytesPerAgent()
+{
+	return StreamCount * sizeof(float) + sizeof(unsigned char);
+}
+
+void CompanionSteeringBatch::Resize(size_t aCount)
+{
+	myCount = aCount;
+	size_t paddedCount = (aCount + maxLaneCount - 1) / maxLaneCount * maxLaneCount;
+
+	// Padding and inactive lanes are worked on like the rest but never read back
+	for (std::vector<float>& stream : myStreams)
+		stream.assign(paddedCount, 0.0f);
+	myIsActive.assign(aCount, 0);
+}
+
+void CompanionSteeringBatch::Reserve(size_t aCount)
+{
+	size_t paddedCount = (aCount + maxLaneCount - 1) / maxLaneCount * maxLaneCount;
+	for (std::vector<float>& stream : myStreams)
+		stream.reserve(paddedCount);
+	myIsActive.reserve(aCount);
+}
+
+void CompanionSteeringBatch::Set(size_t anIndex, const Agent& anAgent)
+{
+	myStreams[PositionX][anIndex] = anAgent.position.x;
+	myStreams[PositionY][anIndex] = anAgent.position.y;
+	myStreams[PositionZ][anIndex] = anAgent.position.z;
+	myStreams[TargetX][anIndex] = anAgent.target.x;
+	myStreams[TargetY][anIndex] = anAgent.target.y;
+	myStreams[TargetZ][anIndex] = anAgent.target.z;
+	myStreams[VelocityX][anIndex] = anAgent.velocity.x;
+	myStreams[VelocityY][anIndex] = anAgent.velocity.y;
+	myStreams[VelocityZ][anIndex] = anAgent.velocity.z;
+	myStreams[FleeX][anIndex] = anAgent.fleeDirection.x;
+	myStreams[FleeY][anIndex] = anAgent.fleeDirection.y;
+	myStreams[FleeZ][anIndex] = anAgent.fleeDirection.z;
+	myStreams[ClosestCollision][anIndex] = anAgent.closestCollision;
+	myStreams[RayLength][anIndex] = anAgent.rayLength;
+	myStreams[MaxSpeed][anIndex] = anAgent.maxSpeed;
+	myStreams[SlowingRadius][anIndex] = anAgent.slowingRadius;
+	myStreams[Blend][anIndex] = anAgent.blend;
+	myIsActive[anIndex] = 1;
+}
+
+template <class Lanes>
+void CompanionSteeringBatch::UpdateLanes()
+{
+	const Lanes zero = Lanes::Broadcast(0.0f);
+	const Lanes one = Lanes::Broadcast(1.0f);
+	const Lanes minDistance = Lanes::Broadcast(minTargetDistance);
+
+	size_t paddedCount = myStreams[PositionX].size();
+	for (size_t i = 0; i < paddedCount; i += Lanes::width)
+	{
+		Lanes toTargetX = Lanes::Load(&myStreams[TargetX][i]) - Lanes::Load(&myStreams[PositionX][i]);
+		Lanes toTargetY = Lanes::Load(&myStreams[TargetY][i]) - Lanes::Load(&myStreams[PositionY][i]);
+		Lanes toTargetZ = Lanes::Load(&myStreams[TargetZ][i]) - Lanes::Load(&myStreams[PositionZ][i]);
+		Lanes distance = Sqrt(toTargetX * toTargetX + toTargetY * toTargetY + toTargetZ * toTargetZ);
+		Lanes inverseDistance = one / Max(distance, minDistance);
+
+		Lanes maxSpeed = Lanes::Load(&myStreams[MaxSpeed][i]);
+		Lanes arrivalRatio = distance / Lanes::Load(&myStreams[SlowingRadius][i]);
+
+		// CalculateWeights
+		Lanes fleeWeight = Max(zero, one - Lanes::Load(&myStreams[ClosestCollision][i]) / Lanes::Load(&myStreams[RayLength][i]));
+		Lanes arrivalWeight = Max(zero, one - arrivalRatio);
+		Lanes seekWeight = Max(zero, one - fleeWeight - arrivalWeight);
+		Lanes totalWeight = fleeWeight + arrivalWeight + seekWeight;
+		Lanes scale = Select(Greater(totalWeight, one), one / totalWeight, one);
+		fleeWeight = fleeWeight * scale;
+		arrivalWeight = arrivalWeight * scale;
+		seekWeight = seekWeight * scale;
+
+		// SeekForce and ArrivalForce both head straight for the target, arrival slows down inside the slowing radius
+		Lanes towardsTargetSpeed = (seekWeight + arrivalWeight * Min(arrivalRatio, one)) * maxSpeed * inverseDistance;
+		Lanes fleeSpeed = fleeWeight * maxSpeed;
+		Lanes forceScale = Lanes::Load(&myStreams[Blend][i]);
+		Lanes velocityWeight = seekWeight + fleeWeight + arrivalWeight;
+
+		Lanes velocityX = Lanes::Load(&myStreams[VelocityX][i]);
+		Lanes velocityY = Lanes::Load(&myStreams[VelocityY][i]);
+		Lanes velocityZ = Lanes::Load(&myStreams[VelocityZ][i]);
+		velocityX = velocityX + (toTargetX * towardsTargetSpeed + Lanes::Load(&myStreams[FleeX][i]) * fleeSpeed - velocityX * velocityWeight) * forceScale;
+		velocityY = velocityY + (toTargetY * towardsTargetSpeed + Lanes::Load(&myStreams[FleeY][i]) * fleeSpeed - velocityY * velocityWeight) * forceScale;
+		velocityZ = velocityZ + (toTargetZ * towardsTargetSpeed + Lanes::Load(&myStreams[FleeZ][i]) * fleeSpeed - velocityZ * velocityWeight) * forceScale;
+
+		// Truncate, clamps the length to the max speed
+		Lanes speed = Sqrt(velocityX * velocityX + velocityY * velocityY + velocityZ * velocityZ);
+		typename Lanes::Mask isTooFast = Greater(speed, maxSpeed);
+		Lanes clampScale = maxSpeed / Max(speed, minDistance);
+		velocityX = Select(isTooFast, velocityX * clampScale, velocityX);
+		velocityY = Select(isTooFast, velocityY * clampScale, velocityY);
+		velocityZ = Select(isTooFast, velocityZ * clampScale, velocityZ);
+
+		velocityX.Store(&myStreams[VelocityX][i]);
+		velocityY.Store(&myStreams[VelocityY][i]);
+		velocityZ.Store(&myStreams[VelocityZ][i]);
+		seekWeight.Store(&myStreams[SeekWeight][i]);
+		fleeWeight.Store(&myStreams[FleeWeight][i]);
+		arrivalWeight.Store(&myStreams[ArrivalWeight][i]);
+	}
+}
+
+void CompanionSteeringBatch::Update()
+{
+	UpdateLanes<VectorLanes>();
+}
+
+void CompanionSteeringBatch::UpdateScalar()
+{
+	UpdateLanes<ScalarLanes>();
+}
+
+DE::Vector3f CompanionSteeringBatch::GetVelocity(size_t anIndex) const
+{
+	return DE::Vector3f(myStreams[VelocityX][anIndex], myStreams[VelocityY][anIndex], myStreams[VelocityZ][anIndex]);
+}
+
+CompanionSteeringBatch::Weights CompanionSteeringBatch::GetWeights(size_t anIndex) const
+{
+	return { myStreams[SeekWeight][anIndex], myStreams[FleeWeight][anIndex], myStreams[ArrivalWeight][anIndex] };
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <DreamEngine/math/Vector3.h>
+
+#include <array>
+#include <vector>
+
+// The seek, arrival, weight blending and Truncate part of CompanionSteeringBehavior::Update for many
+// companions at once. Every companion gets a slot, filled by CompanionSteeringBehavior::BeginUpdate and read
+// back by EndUpdate, and the values are kept as one array per component so Update can work on as many
+// companions per instruction as the build's instruction set allows: 16 with AVX-512, 8 with AVX, 4 with
+// SSE2 and 1 otherwise. UpdateScalar does the same one companion at a time and gives the same results up to
+// rounding.
+class CompanionSteeringBatch
+{
+public:
+	struct Agent
+	{
+		DE::Vector3f position;
+		DE::Vector3f target;
+		DE::Vector3f velocity;
+		// Unit direction away from what the probes hit, zero when nothing is close
+		DE::Vector3f fleeDirection;
+		// Closest hit from the previous update, which is what the flee weight is taken from
+		float closestCollision;
+		float rayLength;
+		float maxSpeed;
+		float slowingRadius;
+		// 1 - e^(-aDeltaTime), the weights always add up to one so this is the whole exponential blend
+		float blend;
+	};
+
+	struct Weights
+	{
+		float seek;
+		float flee;
+		float arrival;
+	};
+
+	// Number of companions Update works on per instruction
+	static size_t GetLaneCount();
+	// Size of one slot
+	static size_t GetBytesPerAgent();
+
+	// Resizes the batch to aCount slots, all of them inactive. Only allocates when it grows past the most
+	// slots reserved or used before.
+	void Resize(size_t aCount);
+	void Reserve(size_t aCount);
+	size_t GetCount() const { return myCount; }
+
+	// Different slots may be set from different threads
+	void Set(size_t anIndex, const Agent& anAgent);
+	// An inactive slot is skipped over by EndUpdate, for companions that aren't steering this frame
+	void SetInactive(size_t anIndex) { myIsActive[anIndex] = 0; }
+	bool IsActive(size_t anIndex) const { return myIsActive[anIndex] != 0; }
+
+	void Update();
+	void UpdateScalar();
+
+	DE::Vector3f GetVelocity(size_t anIndex) const;
+	Weights GetWeights(size_t anIndex) const;
+
+private:
+	enum Stream
+	{
+		PositionX, PositionY, PositionZ,
+		TargetX, TargetY, TargetZ,
+		VelocityX, VelocityY, VelocityZ,
+		FleeX, FleeY, FleeZ,
+		ClosestCollision, RayLength, MaxSpeed, SlowingRadius, Blend,
+		SeekWeight, FleeWeight, ArrivalWeight,
+		StreamCount
+	};
+
+	// The whole batch, Lanes::width companions at a time
+	template <class Lanes>
+	void UpdateLanes();
+
+	// Padded to a whole number of the widest lanes, so Update never needs a remainder loop
+	std::array<std::vector<float>, StreamCount> myStreams;
+	// Bytes rather than bools, so slots can be filled from several threads at once
+	std::vector<unsigned char> myIsActive;
+	size_t myCount = 0;
+};
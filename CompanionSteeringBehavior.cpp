@@ -1,5 +1,8 @@
 #include "CompanionSteeringBehavior.h"
-#include "MainSingleton.h"
+#include "CompanionRaycastBatch.h"
+#include "CompanionSteeringBatch.h"
+#include "CompanionDistanceField.h"
+#include "CompanionContextMap.h"
 
 #include <algorithm>
 #include <cmath>
@@ -17,9 +20,48 @@ namespace
 	// Constants
 	constexpr float minDistance = 25.0f;
 	constexpr float extraFleeLength = 400.f;
-	constexpr float roatationUpOffset = 0.011f;
 	constexpr float sideOffset = 150.f;
 	constexpr float forwardOffset = 300.f;
+
+	// A cached probe is reused while the ray has moved less than this part of the ray length and turned less
+	// than about six degrees
+	constexpr float probeMaxDrift = 0.25f;
+	constexpr float probeMinAlignment = 0.995f;
+	constexpr size_t notQueued = static_cast<size_t>(-1);
+
+	CompanionWorld::RaycastQuery GetProbeQuery(const DE::Transform& aTransform, float aRayLength, eProbe aProbe)
+	{
+		DE::Matrix4x4f matrix = aTransform.GetMatrix();
+		CompanionWorld::RaycastQuery query = { aTransform.GetPosition(), DE::Vector3f(), aRayLength };
+		query.dynamicOnly = CompanionWorld::Get().GetDistanceField() != nullptr;
+
+		switch (aProbe)
+		{
+		case eProbe::Forward:
+			query.direction = matrix.GetForward().GetNormalized();
+			break;
+		case eProbe::Back:
+			query.direction = (matrix.GetForward() * -1.0f).GetNormalized();
+			break;
+		case eProbe::Right:
+			query.direction = matrix.GetRight().GetNormalized();
+			break;
+		case eProbe::Left:
+			query.direction = (matrix.GetRight() * -1.0f).GetNormalized();
+			break;
+		case eProbe::ForwardRight:
+			query.direction = (matrix.GetForward() + matrix.GetRight()).GetNormalized();
+			query.length += extraFleeLength;
+			break;
+		case eProbe::ForwardLeft:
+			query.direction = (matrix.GetForward() + matrix.GetRight() * -1.0f).GetNormalized();
+			query.length += extraFleeLength;
+			break;
+		default:
+			break;
+		}
+		return query;
+	}
 }
 
 CompanionSteeringBehavior::CompanionSteeringBehavior()
@@ -37,26 +79,122 @@ CompanionSteeringBehavior::CompanionSteeringBehavior()
 void CompanionSteeringBehavior::Init(DreamEngine::Transform aTransform)
 {
 	myTransform = aTransform;
+	InvalidateProbes();
+}
+
+void CompanionSteeringBehavior::InvalidateProbes()
+{
+	for (CachedProbe& cached : myProbeCache)
+		cached.isValid = false;
+}
+
+void CompanionSteeringBehavior::QueueProbes(DE::Transform aTransform, CompanionRaycastBatch& aBatch)
+{
+	myProbeBatch = &aBatch;
+	for (int i = 0; i < static_cast<int>(eProbe::count); i++)
+	{
+		eProbe probe = static_cast<eProbe>(i);
+		CompanionWorld::RaycastQuery query = GetProbeQuery(aTransform, myRayLength, probe);
+		myQueuedProbes[i] = notQueued;
+
+		// The forces only look at the diagonals when the forward ray hits, going by the last forward result.
+		// If that guess is wrong Probe casts them itself. Context steering always looks at every probe.
+		const CachedProbe& forward = myProbeCache[static_cast<size_t>(eProbe::Forward)];
+		bool isDiagonal = probe == eProbe::ForwardRight || probe == eProbe::ForwardLeft;
+		if (myMode == eSteeringMode::Forces && isDiagonal && forward.isValid && !forward.hit)
+			continue;
+
+		if (!IsCached(probe, query))
+			myQueuedProbes[i] = aBatch.Add(query);
+	}
 }
 
 DE::Vector3f CompanionSteeringBehavior::Update(float aDeltaTime, DE::Transform aTransform, DE::Vector3f aTarget)
 {
 	auto lenght = (aTarget - aTransform.GetPosition()).Length();
 	if (lenght <= minDistance)
+	{
+		myProbeBatch = nullptr;
 		return 0.0f;
+	}
 
 	myTransform = aTransform;
 	myTarget = aTarget;
 
+	if (myMode == eSteeringMode::Context)
+	{
+		myVelocity = ContextSteering(aDeltaTime);
+		myProbeBatch = nullptr;
+		myRefreshProbe = (myRefreshProbe + 1) % static_cast<int>(eProbe::count);
+		return myVelocity;
+	}
+
 	CalculateWeights();
 
 	DreamEngine::Vector3f seekForce = SeekForce() * mySeekWeight;
 	DreamEngine::Vector3f fleeForce = FleeForce() * myFleeWeight;
 	DreamEngine::Vector3f arrivalForce = ArrivalForce(myTarget) * myArivalWeight;
 
-	myVelocity += (seekForce + fleeForce + arrivalForce) * aDeltaTime;
+	// Every force is a weighted (desired - current) velocity, so together they pull the velocity towards the
+	// weighted desired velocity. Blending exponentially keeps that stable for the long steps of companions
+	// updated at a reduced rate, and matches force * aDeltaTime for short ones.
+	float totalWeight = mySeekWeight + myFleeWeight + myArivalWeight;
+	if (totalWeight > 0.0f)
+		myVelocity += (seekForce + fleeForce + arrivalForce) * ((1.0f - std::exp(-totalWeight * aDeltaTime)) / totalWeight);
 	myVelocity = Truncate(myVelocity, myMaxSpeed);
 
+	myProbeBatch = nullptr;
+	myRefreshProbe = (myRefreshProbe + 1) % static_cast<int>(eProbe::count);
+	return myVelocity;
+}
+
+void CompanionSteeringBehavior::BeginUpdate(float aDeltaTime, DE::Transform aTransform, DE::Vector3f aTarget, CompanionSteeringBatch& aBatch, size_t anIndex)
+{
+	myIsSteeredOutsideBatch = false;
+	auto lenght = (aTarget - aTransform.GetPosition()).Length();
+	if (lenght <= minDistance)
+	{
+		myProbeBatch = nullptr;
+		aBatch.SetInactive(anIndex);
+		return;
+	}
+
+	myTransform = aTransform;
+	myTarget = aTarget;
+
+	// The batch only knows the forces, context steering is done here and the slot left out
+	if (myMode == eSteeringMode::Context)
+	{
+		myVelocity = ContextSteering(aDeltaTime);
+		myIsSteeredOutsideBatch = true;
+		aBatch.SetInactive(anIndex);
+		myProbeBatch = nullptr;
+		myRefreshProbe = (myRefreshProbe + 1) % static_cast<int>(eProbe::count);
+		return;
+	}
+
+	// The flee weight goes by the closest hit of the previous update, as in Update
+	float closestCollision = myClosestCollision;
+	DE::Vector3f fleeDirection = FleeDirection();
+
+	aBatch.Set(anIndex, { myTransform.GetPosition(), myTarget, myVelocity, fleeDirection, closestCollision,
+		myRayLength, myMaxSpeed, mySlowingRadius, 1.0f - std::exp(-aDeltaTime) });
+
+	myProbeBatch = nullptr;
+	myRefreshProbe = (myRefreshProbe + 1) % static_cast<int>(eProbe::count);
+}
+
+DE::Vector3f CompanionSteeringBehavior::EndUpdate(const CompanionSteeringBatch& aBatch, size_t anIndex)
+{
+	if (!aBatch.IsActive(anIndex))
+		return myIsSteeredOutsideBatch ? myVelocity : 0.0f;
+
+	CompanionSteeringBatch::Weights weights = aBatch.GetWeights(anIndex);
+	mySeekWeight = weights.seek;
+	myFleeWeight = weights.flee;
+	myArivalWeight = weights.arrival;
+
+	myVelocity = aBatch.GetVelocity(anIndex);
 	return myVelocity;
 }
 
@@ -88,11 +226,21 @@ DE::Vector3f CompanionSteeringBehavior::SeekForce()
 
 DE::Vector3f CompanionSteeringBehavior::FleeForce()
 {
-	std::vector<eRayDir> collisionDirections = DirectionAvoidance();
+	DreamEngine::Vector3f desiredVelocity = FleeDirection() * myMaxSpeed;
+	myFleeForce = desiredVelocity - myVelocity;
+
+	return myFleeForce;
+}
+
+DE::Vector3f CompanionSteeringBehavior::FleeDirection()
+{
+	std::array<eRayDir, 2> collisionDirections;
+	size_t collisionCount = DirectionAvoidance(collisionDirections);
 	DreamEngine::Vector3f fleeDirection;
 
-	for (eRayDir dir : collisionDirections)
+	for (size_t i = 0; i < collisionCount; ++i)
 	{
+		eRayDir dir = collisionDirections[i];
 		if (dir != eRayDir::count)
 		{
 			auto matrix = myTransform.GetMatrix();
@@ -101,10 +249,7 @@ DE::Vector3f CompanionSteeringBehavior::FleeForce()
 			{
 			case eRayDir::Forward:
 			{
-				DE::Vector3f directionR = (matrix.GetForward() + matrix.GetRight()).GetNormalized();
-				DE::Vector3f directionL = (matrix.GetForward() + matrix.GetRight() * -1.0f).GetNormalized();
-
-				if (CollisionCheck(myTransform.GetPosition(), directionR, extraFleeLength) && CollisionCheck(myTransform.GetPosition(), directionL, extraFleeLength) && myClosestCollision < 70.f)
+				if (Probe(eProbe::ForwardRight) && Probe(eProbe::ForwardLeft) && myClosestCollision < 70.f)
 				{
 					fleeDirection = matrix.GetForward() * -1.0f;
 					fleeDirection = matrix.GetUp();
@@ -112,14 +257,14 @@ DE::Vector3f CompanionSteeringBehavior::FleeForce()
 				}
 				else
 				{
-					if (CollisionCheck(myTransform.GetPosition(), directionR, extraFleeLength))	//checking a bit futher away 
+					if (Probe(eProbe::ForwardRight))	//checking a bit futher away 
 					{
 						fleeDirection = matrix.GetRight() * -1.0f;
 						fleeDirection += matrix.GetForward() * -1.0f;
 						fleeDirection += matrix.GetUp();
 						break;
 					}
-					if (CollisionCheck(myTransform.GetPosition(), directionL, extraFleeLength))
+					if (Probe(eProbe::ForwardLeft))
 					{
 						fleeDirection += matrix.GetRight();
 						fleeDirection += matrix.GetForward() * -1.0f;
@@ -148,46 +293,106 @@ DE::Vector3f CompanionSteeringBehavior::FleeForce()
 				break;
 			}
 		}
-		else
-			myFleeForce = 0.0f;
 	}
 
-	fleeDirection = fleeDirection.GetNormalized();
-
-	DreamEngine::Vector3f desiredVelocity = fleeDirection * myMaxSpeed;
-	myFleeForce = desiredVelocity - myVelocity;
+	// Static geometry comes from the distance field when there is one, the probes then only see moving actors
+	if (const CompanionDistanceField* field = CompanionWorld::Get().GetDistanceField())
+	{
+		float distance;
+		DE::Vector3f awayFromSurface;
+		if (field->Sample(myTransform.GetPosition(), distance, awayFromSurface) && distance < myRayLength)
+		{
+			myClosestCollision = std::min(myClosestCollision, std::max(0.0f, distance));
+			fleeDirection += awayFromSurface;
+		}
+	}
 
-	return myFleeForce;
+	return fleeDirection.GetNormalized();
 }
 
-bool CompanionSteeringBehavior::CollisionCheck(const DreamEngine::Vector3f aPosition, const DreamEngine::Vector3f aDirection, float anAdditionalLength)
+DE::Vector3f CompanionSteeringBehavior::ContextSteering(float aDeltaTime)
 {
-	physx::PxVec3 origin = physx::PxVec3(aPosition.x, aPosition.y, aPosition.z);
-	physx::PxVec3 direction = physx::PxVec3(aDirection.x, aDirection.y, aDirection.z);
+	CompanionContextMap context;
 
-	auto collisionFiltering = MainSingleton::GetInstance()->GetCollisionFiltering();
-	physx::PxQueryFilterData queryFilterData;
-	queryFilterData.data.word0 = collisionFiltering.Environment;
+	DE::Vector3f toTarget = myTarget - myTransform.GetPosition();
+	float distance = toTarget.Length();
+	context.AddInterest(toTarget / distance);
 
-	physx::PxRaycastBufferN<64> hitInfo;
-	if (MainSingleton::GetInstance()->GetPhysXScene()->raycast(
-		origin, direction, (myRayLength + anAdditionalLength), hitInfo, physx::PxHitFlag::eDEFAULT, queryFilterData))
+	// Every probe that hits is danger in its direction, the closer the hit the stronger
+	myClosestCollision = myRayLength;
+	for (int i = 0; i < static_cast<int>(eProbe::count); ++i)
 	{
-		for (physx::PxU32 j = 0; j < hitInfo.nbTouches; ++j)
-		{
-			const physx::PxRaycastHit& hit = hitInfo.touches[j];
-			if (hit.actor->getName(), "Companion" == 0) continue; // Ignore own body
-			myCollisionDist = hit.distance;
+		eProbe probe = static_cast<eProbe>(i);
+		if (!Probe(probe))
+			continue;
+
+		CompanionWorld::RaycastQuery query = GetProbeQuery(myTransform, myRayLength, probe);
+		context.AddDanger(query.direction, 1.0f - myCollisionDist / query.length);
+		myClosestCollision = std::min(myClosestCollision, myCollisionDist);
+	}
 
-			return true;
+	if (const CompanionDistanceField* field = CompanionWorld::Get().GetDistanceField())
+	{
+		float surfaceDistance;
+		DE::Vector3f awayFromSurface;
+		if (field->Sample(myTransform.GetPosition(), surfaceDistance, awayFromSurface) && surfaceDistance < myRayLength)
+		{
+			surfaceDistance = std::max(0.0f, surfaceDistance);
+			context.AddDanger(awayFromSurface * -1.0f, 1.0f - surfaceDistance / myRayLength);
+			myClosestCollision = std::min(myClosestCollision, surfaceDistance);
 		}
 	}
 
-	myCollisionDist = myRayLength;
-	return false;
+	// Arrival's speed along the best direction, blended in the same way as the forces
+	float speed = myMaxSpeed * std::min(1.0f, distance / mySlowingRadius);
+	DE::Vector3f desiredVelocity = context.GetBestDirection() * speed;
+	myVelocity += (desiredVelocity - myVelocity) * (1.0f - std::exp(-aDeltaTime));
+	return Truncate(myVelocity, myMaxSpeed);
 }
 
-std::vector<eRayDir> CompanionSteeringBehavior::DirectionAvoidance()
+bool CompanionSteeringBehavior::Probe(eProbe aProbe)
+{
+	CompanionWorld::RaycastQuery query = GetProbeQuery(myTransform, myRayLength, aProbe);
+	CachedProbe& cached = myProbeCache[static_cast<size_t>(aProbe)];
+
+	size_t queued = myProbeBatch != nullptr ? myQueuedProbes[static_cast<size_t>(aProbe)] : notQueued;
+	if (queued != notQueued)
+	{
+		const CompanionWorld::RaycastResult& result = myProbeBatch->GetResult(queued);
+		cached = { query, result.distance, result.hit, true };
+	}
+	else if (!IsCached(aProbe, query))
+	{
+		CompanionWorld::RaycastResult result;
+		CompanionWorld::Get().RaycastBatch(&query, &result, 1);
+		cached = { query, result.distance, result.hit, true };
+	}
+
+	if (!cached.hit)
+	{
+		myCollisionDist = myRayLength;
+		return false;
+	}
+
+	// Moving along the ray since it was cast brings the hit that much closer
+	float travelled = (query.origin - cached.query.origin).Dot(cached.query.direction);
+	myCollisionDist = std::max(0.0f, cached.distance - travelled);
+	return true;
+}
+
+bool CompanionSteeringBehavior::IsCached(eProbe aProbe, const CompanionWorld::RaycastQuery& aQuery) const
+{
+	const CachedProbe& cached = myProbeCache[static_cast<size_t>(aProbe)];
+	if (!cached.isValid || static_cast<int>(aProbe) == myRefreshProbe)
+		return false;
+
+	float maxDrift = myRayLength * probeMaxDrift;
+	return (aQuery.origin - cached.query.origin).LengthSqr() < maxDrift * maxDrift
+		&& aQuery.direction.Dot(cached.query.direction) > probeMinAlignment
+		&& aQuery.dynamicOnly == cached.query.dynamicOnly;
+}
+
+size_t CompanionSteeringBehavior::DirectionAvoidance(std::array<eRayDir, 2>& someDirections)
 {
 	struct RayInfo
 	{
@@ -196,49 +401,50 @@ std::vector<eRayDir> CompanionSteeringBehavior::DirectionAvoidance()
 		DE::Vector3f position;
 	};
 
-	DE::Matrix4x4f matrix = myTransform.GetMatrix();
-	std::vector<RayInfo> rayInfoList;
+	// At most one hit per probe, kept on the stack as this runs every update
+	std::array<RayInfo, static_cast<size_t>(eProbe::count)> rayInfoList;
+	size_t rayInfoCount = 0;
 
 	for (int i = 0; i < static_cast<int>(eRayDir::count); ++i)
 	{
 		eRayDir currentDir = static_cast<eRayDir>(i);
-		DE::Vector3f direction;
 		DE::Vector3f position = myTransform.GetPosition();
 
-		// Determine the direction vector based on the current ray direction
+		eProbe probe;
 		switch (currentDir)
 		{
 		case eRayDir::Forward:
-			direction = matrix.GetForward().GetNormalized();
+			probe = eProbe::Forward;
 			break;
 		case eRayDir::Back:
-			direction = (matrix.GetForward() * -1.0f).GetNormalized();
+			probe = eProbe::Back;
 			break;
 		case eRayDir::Right:
-			direction = matrix.GetRight().GetNormalized();
+			probe = eProbe::Right;
 			break;
 		case eRayDir::Left:
-			direction = (matrix.GetRight() * -1.0f).GetNormalized();
+			probe = eProbe::Left;
 			break;
 		default:
 			continue;
 		}
 
 		// Check for collisions in the current direction
-		if (CollisionCheck(position, direction, 0.0f))
+		if (Probe(probe))
 		{
-			rayInfoList.push_back({ currentDir, myCollisionDist, position });
+			rayInfoList[rayInfoCount++] = { currentDir, myCollisionDist, position };
 		}
 	}
 
 	float closestDist = myRayLength;
 	myClosestCollision = myRayLength;
-	std::vector<eRayDir> resultDirections;
+	size_t resultCount = 0;
 
-	if (rayInfoList.size() == 2)
+	if (rayInfoCount == 2)
 	{
-		for (const auto& info : rayInfoList)
+		for (size_t i = 0; i < rayInfoCount; ++i)
 		{
+			const RayInfo& info = rayInfoList[i];
 			if (closestDist == 0.0f || closestDist > info.closestCollision)
 			{
 				closestDist = info.closestCollision;
@@ -246,14 +452,15 @@ std::vector<eRayDir> CompanionSteeringBehavior::DirectionAvoidance()
 		}
 
 		myClosestCollision = closestDist;
-		resultDirections.push_back(rayInfoList[0].direction);
-		resultDirections.push_back(rayInfoList[1].direction);
+		someDirections[resultCount++] = rayInfoList[0].direction;
+		someDirections[resultCount++] = rayInfoList[1].direction;
 	}
-	else if (!rayInfoList.empty())
+	else if (rayInfoCount > 0)
 	{
 		RayInfo closestRayInfo = rayInfoList[0];
-		for (const auto& info : rayInfoList)
+		for (size_t i = 0; i < rayInfoCount; ++i)
 		{
+			const RayInfo& info = rayInfoList[i];
 			if (closestDist == 0.0f || closestDist > info.closestCollision)
 			{
 				closestDist = info.closestCollision;
@@ -262,10 +469,10 @@ std::vector<eRayDir> CompanionSteeringBehavior::DirectionAvoidance()
 		}
 
 		myClosestCollision = closestDist;
-		resultDirections.push_back(closestRayInfo.direction);
+		someDirections[resultCount++] = closestRayInfo.direction;
 	}
 
-	return resultDirections;
+	return resultCount;
 }
 
 DE::Vector3f CompanionSteeringBehavior::Truncate(const DreamEngine::Vector3f aDirection, float aSpeed)
@@ -273,77 +480,25 @@ DE::Vector3f CompanionSteeringBehavior::Truncate(const DreamEngine::Vector3f aDi
 	float length = aDirection.Length();
 	if (length > aSpeed)
 	{
-		return aDirection.GetNormalized() * aDirection;
+		return aDirection.GetNormalized() * aSpeed;
 	}
 	return aDirection;
 }
 
-DE::Vector3f CompanionSteeringBehavior::RotateToThisOverTime(DreamEngine::Vector3f aPoint, float aDeltaTime, float aRotationSpeed, DreamEngine::Vector3f aCurrentRotation)
+CompanionOrientation CompanionSteeringBehavior::RotateToThisOverTime(DreamEngine::Vector3f aPoint, float aDeltaTime, float aRotationSpeed, const CompanionOrientation& aCurrentOrientation)
 {
-	auto myCurrentDir = aPoint.GetNormalized();
-
-	DreamEngine::Vector3f up = DreamEngine::Vector3f(0, 1, 0) + myCurrentDir * 0.011f;
-	up = up.GetNormalized();
-
-	DreamEngine::Vector3f forward = { 0.f, 1.f, 0.f };
-	forward = (forward - forward.Dot(up) * up).GetNormalized();
-	forward *= -1.f;
-
-	DreamEngine::Vector3f right = up.Cross(forward).GetNormalized();
-
-	DE::Quatf q = DE::Quatf::CreateFromOrthonormalBasisVectors(right, up, forward);
-	DE::Vector3f rotation = q.GetEulerAnglesDegrees();
-
-	DE::Vector3f delta = rotation - aCurrentRotation;
-
-	while (delta.x > 180) delta.x -= 360;
-	while (delta.x < -180) delta.x += 360;
-	while (delta.y > 180) delta.y -= 360;
-	while (delta.y < -180) delta.y += 360;
-	while (delta.z > 180) delta.z -= 360;
-	while (delta.z < -180) delta.z += 360;
-
-	DE::Vector3f newRotation = aCurrentRotation + delta * aRotationSpeed * aDeltaTime;
-
-	return newRotation;
+	// Exponential approach, so a long delta time moves towards the target without overshooting it
+	return CompanionOrientation::Nlerp(aCurrentOrientation, RotateToThis(aPoint), 1.0f - std::exp(-aRotationSpeed * aDeltaTime));
 }
 
-DE::Vector3f CompanionSteeringBehavior::RotateToThis(DreamEngine::Vector3f aPoint)
+CompanionOrientation CompanionSteeringBehavior::RotateToThis(DreamEngine::Vector3f aPoint)
 {
-	auto myCurrentDir = aPoint.GetNormalized();
-
-	DreamEngine::Vector3f up = DreamEngine::Vector3f(0, 1, 0) + myCurrentDir * 0.011f;
-	up = up.GetNormalized();
-
-	DreamEngine::Vector3f forward = { 0.f, 1.f, 0.f };
-	forward = (forward - forward.Dot(up) * up).GetNormalized();
-	forward *= -1.f;
-
-	DreamEngine::Vector3f right = up.Cross(forward).GetNormalized();
-
-	DE::Quatf q = DE::Quatf::CreateFromOrthonormalBasisVectors(right, up, forward);
-	DE::Vector3f rotation = q.GetEulerAnglesDegrees();
-
-	return rotation;
+	return CompanionOrientation::LookRotation(aPoint);
 }
 
-DE::Vector3f CompanionSteeringBehavior::RotateToVelocity()
+CompanionOrientation CompanionSteeringBehavior::RotateToVelocity()
 {
-	auto myCurrentDir = myVelocity.GetNormalized();
-
-	DreamEngine::Vector3f up = DreamEngine::Vector3f(0, 1, 0) + myCurrentDir * 0.011f;
-	up = up.GetNormalized();
-
-	DreamEngine::Vector3f forward = { 0.f, 1.f, 0.f };
-	forward = (forward - forward.Dot(up) * up).GetNormalized();
-	forward *= -1.f;
-
-	DreamEngine::Vector3f right = up.Cross(forward).GetNormalized();
-
-	DE::Quatf q = DE::Quatf::CreateFromOrthonormalBasisVectors(right, up, forward);
-	DE::Vector3f rotation = q.GetEulerAnglesDegrees();
-
-	return rotation;
+	return CompanionOrientation::LookRotation(myVelocity);
 }
 
 DE::Vector3f CompanionSteeringBehavior::SetOffsetToPlayer(DE::Vector3f aPlayerPos)
@@ -355,7 +510,7 @@ DE::Vector3f CompanionSteeringBehavior::SetOffsetToPlayer(DE::Vector3f aPlayerPo
 	{
 	case Bilateral::Left:
 	{
-		auto cam = MainSingleton::GetInstance()->GetActiveCamera()->GetTransform().GetMatrix();
+		auto cam = CompanionWorld::Get().GetCameraTransform().GetMatrix();
 		offset = offset + (cam.GetForward().GetNormalized() * forwardOffset);
 		offset = offset + (cam.GetRight().GetNormalized() * -sideOffset);
 		offset.y += myRayLength;
@@ -365,7 +520,7 @@ DE::Vector3f CompanionSteeringBehavior::SetOffsetToPlayer(DE::Vector3f aPlayerPo
 	}
 	case Bilateral::Right:
 	{
-		auto cam = MainSingleton::GetInstance()->GetActiveCamera()->GetTransform().GetMatrix();
+		auto cam = CompanionWorld::Get().GetCameraTransform().GetMatrix();
 		offset = offset + (cam.GetForward().GetNormalized() * forwardOffset);
 		offset = offset + (cam.GetRight().GetNormalized() * sideOffset);
 		offset.y += myRayLength;
@@ -415,15 +570,15 @@ void CompanionSteeringBehavior::CalculateWeights()
 	myFleeWeight = std::max(0.0f, 1.0f - (myClosestCollision / myRayLength));
 
 	float distanceToTarget = (myTarget - myTransform.GetPosition()).Length();
-	myArrivalWeight = std::max(0.0f, 1.0f - distanceToTarget / mySlowingRadius);
+	myArivalWeight = std::max(0.0f, 1.0f - distanceToTarget / mySlowingRadius);
 
-	mySeekWeight = std::max(0.0f, 1.0f - myFleeWeight - myArrivalWeight - myPredictWeight);
+	mySeekWeight = std::max(0.0f, 1.0f - myFleeWeight - myArivalWeight - myPredictWeight);
 
-	float totalWeight = myFleeWeight + myArrivalWeight + myPredictWeight + mySeekWeight;
+	float totalWeight = myFleeWeight + myArivalWeight + myPredictWeight + mySeekWeight;
 	if(totalWeight > 1.0f)
 	{
 		myFleeWeight /= totalWeight;
-		myArrivalWeight /= totalWeight;
+		myArivalWeight /= totalWeight;
 		myPredictWeight /= totalWeight;
 		mySeekWeight /= totalWeight;
 	}
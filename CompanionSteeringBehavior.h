@@ -1,18 +1,64 @@
 #pragma once
-#include <DreamEngine\math\Vector3.h>
+#include <DreamEngine/math/Vector3.h>
 #include <DreamEngine/math/Transform.h>
 #include <DreamEngine/graphics/GraphicsEngine.h>
+#include "CompanionWorld.h"
+#include "CompanionOrientation.h"
+
+#include <array>
 
 enum class Bilateral { Left, Right, Reset };
 enum class eRayDir { Forward, Back, Up, Down, Right, Left, count };
+// Environment raycasts of one steering update, the diagonals reach further and are only looked at when the forward ray hits
+enum class eProbe { Forward, Back, Right, Left, ForwardRight, ForwardLeft, count };
+// How Update turns the target and the probes into a velocity. Forces blends seek, arrival and flee forces by
+// weight. Context rates directions around the companion, see CompanionContextMap, which keeps it out of the
+// corners where the forces cancel out.
+enum class eSteeringMode { Forces, Context };
+
+class CompanionRaycastBatch;
+class CompanionSteeringBatch;
 
 class CompanionSteeringBehavior
 {
 public:
+	// The steering state carried from one update to the next
+	struct Snapshot
+	{
+		DE::Vector3f velocity;
+		Bilateral bilateral;
+		float closestCollision;
+		float collisionDist;
+	};
+
 	CompanionSteeringBehavior();
 
 	void Init(DreamEngine::Transform aTransform);
+	void SetMode(eSteeringMode aMode) { myMode = aMode; }
+	eSteeringMode GetMode() const { return myMode; }
+
+	void Save(Snapshot& aSnapshot) const { aSnapshot = { myVelocity, myBilateral, myClosestCollision, myCollisionDist }; }
+	void Restore(const Snapshot& aSnapshot)
+	{
+		myVelocity = aSnapshot.velocity;
+		myBilateral = aSnapshot.bilateral;
+		myClosestCollision = aSnapshot.closestCollision;
+		myCollisionDist = aSnapshot.collisionDist;
+		InvalidateProbes();
+	}
+	// Adds the raycasts the next Update from aTransform can't take from its probe cache to aBatch. That Update
+	// reads the results from the batch, which has to be submitted by then, instead of casting its own rays.
+	void QueueProbes(DE::Transform aTransform, CompanionRaycastBatch& aBatch);
+	// Forgets queued raycasts that no Update used
+	void ClearProbes() { myProbeBatch = nullptr; }
+	// Makes every probe cast again on its next use, for when the companion is moved rather than steered
+	void InvalidateProbes();
 	DE::Vector3f Update(float aDeltaTime, DE::Transform aTransform, DE::Vector3f aTarget);
+	// Update split around a CompanionSteeringBatch: BeginUpdate probes the environment and fills slot anIndex,
+	// and once the batch is updated EndUpdate takes the new velocity from it. In context mode BeginUpdate
+	// steers on its own and leaves the slot inactive.
+	void BeginUpdate(float aDeltaTime, DE::Transform aTransform, DE::Vector3f aTarget, CompanionSteeringBatch& aBatch, size_t anIndex);
+	DE::Vector3f EndUpdate(const CompanionSteeringBatch& aBatch, size_t anIndex);
 
 	// Steering forces
 	DE::Vector3f ArrivalForce(const DreamEngine::Vector3f aDirection);
@@ -20,17 +66,34 @@ public:
 	DE::Vector3f FleeForce();
 
 	// Rotation methods
-	DE::Vector3f RotateToThisOverTime(DreamEngine::Vector3f aPoint, float aDeltaTime, float aRotationSpeed, DreamEngine::Vector3f aCurrentRotation);
-	DE::Vector3f RotateToThis(DreamEngine::Vector3f aPoint);
-	DE::Vector3f RotateToVelocity();
+	CompanionOrientation RotateToThisOverTime(DreamEngine::Vector3f aPoint, float aDeltaTime, float aRotationSpeed, const CompanionOrientation& aCurrentOrientation);
+	CompanionOrientation RotateToThis(DreamEngine::Vector3f aPoint);
+	CompanionOrientation RotateToVelocity();
 
 	// Position/offset methods
 	DE::Vector3f SetOffsetToPlayer(DE::Vector3f aPlayerPos);
 	Bilateral ChoseClosesBilateral(DE::Vector3f aPlayerPos);
 
 private:
-	bool CollisionCheck(const DreamEngine::Vector3f aPosition, const DreamEngine::Vector3f aDirection, float anAdditionalLenght);
-	std::vector<eRayDir> DirectionAvoidance();
+	// A probe result and the ray it was cast along
+	struct CachedProbe
+	{
+		CompanionWorld::RaycastQuery query;
+		float distance = 0.0f;
+		bool hit = false;
+		bool isValid = false;
+	};
+
+	// Casts aProbe from the current transform, looks it up in the queued batch or reuses the cached result
+	// when the companion has barely moved since it was cast. Sets myCollisionDist.
+	bool Probe(eProbe aProbe);
+	bool IsCached(eProbe aProbe, const CompanionWorld::RaycastQuery& aQuery) const;
+	// Fills someDirections with the one or two directions to avoid and returns how many there are
+	size_t DirectionAvoidance(std::array<eRayDir, 2>& someDirections);
+	// Unit direction FleeForce steers towards, zero when nothing is close
+	DE::Vector3f FleeDirection();
+	// The velocity of an Update in context mode
+	DE::Vector3f ContextSteering(float aDeltaTime);
 
 	void CalculateWeights();
 	DE::Vector3f Truncate(const DreamEngine::Vector3f aDirection, float aSpeed);
@@ -39,6 +102,9 @@ private:
 
 private:
 	Bilateral myBilateral;
+	eSteeringMode myMode = eSteeringMode::Forces;
+	// Set by BeginUpdate when it steered without the batch, myVelocity then already holds the result
+	bool myIsSteeredOutsideBatch = false;
 	DreamEngine::Transform myTransform;
 	DE::Vector3f myTarget;
 	DE::Vector3f myVelocity;
@@ -55,4 +121,12 @@ private:
 	float myFleeWeight = 0.0f;
 	float myArivalWeight = 0.0f;
 	float myPredictWeight = 0.0f;
+
+	std::array<CachedProbe, static_cast<size_t>(eProbe::count)> myProbeCache;
+	// The probe cast again on its next use even if its cached result is still good, one per update in turn
+	int myRefreshProbe = 0;
+
+	const CompanionRaycastBatch* myProbeBatch = nullptr;
+	// Index of each probe's result in myProbeBatch, or notQueued
+	std::array<size_t, static_cast<size_t>(eProbe::count)> myQueuedProbes;
 };
@@ -0,0 +1,245 @@
+#include "CompanionTargetGrid.h"
+#include "FlyingEnemy.h"
+#include "GroundEnemy.h"
+
+#include <assert.h>
+#include <cmath>
+
+namespace
+{
+	// Larger queries than this many cells scan every entry instead, which is cheaper by then
+	constexpr size_t maxQueryCells = 512;
+}
+
+CompanionTargetGrid::CompanionTargetGrid(float aCellSize, size_t aBucketCount): myCellSize(aCellSize), myInverseCellSize(1.0f / aCellSize)
+{
+	size_t bucketCount = 1;
+	while (bucketCount < aBucketCount)
+		bucketCount *= 2;
+	myBuckets.assign(bucketCount, invalidHandle);
+}
+
+CompanionTargetGrid::Handle CompanionTargetGrid::Add(const DE::Transform& aTransform)
+{
+	Handle handle = myFreeEntries;
+	if (handle == invalidHandle)
+	{
+		handle = static_cast<Handle>(myEntries.size());
+		myEntries.push_back({});
+	}
+	else
+	{
+		myFreeEntries = myEntries[handle].next;
+	}
+
+	Entry& entry = myEntries[handle];
+	entry.target = { &aTransform, aTransform.GetPosition() };
+	entry.cellX = GetCell(entry.target.position.x);
+	entry.cellY = GetCell(entry.target.position.y);
+	entry.cellZ = GetCell(entry.target.position.z);
+	entry.isUsed = true;
+	Link(handle);
+	myCount++;
+	return handle;
+}
+
+void CompanionTargetGrid::Move(Handle aHandle)
+{
+	Entry& entry = myEntries[aHandle];
+	assert(entry.isUsed && "Moving a target that was removed");
+	entry.target.position = entry.target.transform->GetPosition();
+
+	int cellX = GetCell(entry.target.position.x);
+	int cellY = GetCell(entry.target.position.y);
+	int cellZ = GetCell(entry.target.position.z);
+	if (cellX == entry.cellX && cellY == entry.cellY && cellZ == entry.cellZ)
+		return;
+
+	Unlink(aHandle);
+	entry.cellX = cellX;
+	entry.cellY = cellY;
+	entry.cellZ = cellZ;
+	Link(aHandle);
+}
+
+void CompanionTargetGrid::Remove(Handle aHandle)
+{
+	Entry& entry = myEntries[aHandle];
+	assert(entry.isUsed && "Removing a target twice");
+	Unlink(aHandle);
+	entry.isUsed = false;
+	entry.next = myFreeEntries;
+	myFreeEntries = aHandle;
+	myCount--;
+}
+
+void CompanionTargetGrid::Clear()
+{
+	myBuckets.assign(myBuckets.size(), invalidHandle);
+	myEntries.clear();
+	myFreeEntries = invalidHandle;
+	myCount = 0;
+	myFlyingHandles.clear();
+	myGroundHandles.clear();
+}
+
+void CompanionTargetGrid::Sync(const std::vector<std::shared_ptr<FlyingEnemy>>& someFlyingEnemies, const std::vector<std::shared_ptr<GroundEnemy>>& someGroundEnemies)
+{
+	SyncList(someFlyingEnemies, myFlyingHandles);
+	SyncList(someGroundEnemies, myGroundHandles);
+}
+
+template <class Enemy>
+void CompanionTargetGrid::SyncList(const std::vector<std::shared_ptr<Enemy>>& someEnemies, std::vector<Handle>& someHandles)
+{
+	// Enemies dropped from the end of the list
+	for (size_t i = someEnemies.size(); i < someHandles.size(); i++)
+	{
+		if (someHandles[i] != invalidHandle)
+			Remove(someHandles[i]);
+	}
+	someHandles.resize(someEnemies.size(), invalidHandle);
+
+	for (size_t i = 0; i < someEnemies.size(); i++)
+	{
+		Handle& handle = someHandles[i];
+		const DE::Transform* transform = someEnemies[i] != nullptr && someEnemies[i]->IsAlive() ? someEnemies[i]->GetTransform() : nullptr;
+
+		// A different enemy in the slot than last time is a removal and an add
+		if (handle != invalidHandle && myEntries[handle].target.transform != transform)
+		{
+			Remove(handle);
+			handle = invalidHandle;
+		}
+
+		if (transform == nullptr)
+			continue;
+		if (handle == invalidHandle)
+			handle = Add(*transform);
+		else
+			Move(handle);
+	}
+}
+
+const CompanionTargetGrid::Target* CompanionTargetGrid::FindNearest(const DE::Vector3f& aPosition, float aRadius) const
+{
+	const Target* nearest = nullptr;
+	float nearestDistanceSqr = aRadius * aRadius;
+	ForEachWithin(aPosition, aRadius, [&nearest, &nearestDistanceSqr](const Entry& anEntry, float aDistanceSqr)
+		{
+			if (aDistanceSqr <= nearestDistanceSqr)
+			{
+				nearestDistanceSqr = aDistanceSqr;
+				nearest = &anEntry.target;
+			}
+		});
+	return nearest;
+}
+
+size_t CompanionTargetGrid::FindNearest(const DE::Vector3f& aPosition, float aRadius, const Target** someTargets, size_t aMaxCount) const
+{
+	if (aMaxCount == 0)
+		return 0;
+
+	// Kept sorted by inserting, aMaxCount is expected to be a handful
+	size_t count = 0;
+	ForEachWithin(aPosition, aRadius, [this, &aPosition, someTargets, aMaxCount, &count](const Entry& anEntry, float aDistanceSqr)
+		{
+			if (count == aMaxCount && aDistanceSqr >= (someTargets[count - 1]->position - aPosition).LengthSqr())
+				return;
+
+			size_t slot = count < aMaxCount ? count++ : count - 1;
+			while (slot > 0 && (someTargets[slot - 1]->position - aPosition).LengthSqr() > aDistanceSqr)
+			{
+				someTargets[slot] = someTargets[slot - 1];
+				slot--;
+			}
+			someTargets[slot] = &anEntry.target;
+		});
+	return count;
+}
+
+void CompanionTargetGrid::FindNearest(const DE::Vector3f* somePositions, size_t aCount, float aRadius, const Target** someTargets) const
+{
+	for (size_t i = 0; i < aCount; i++)
+		someTargets[i] = FindNearest(somePositions[i], aRadius);
+}
+
+template <class Visit>
+void CompanionTargetGrid::ForEachWithin(const DE::Vector3f& aPosition, float aRadius, Visit&& aVisit) const
+{
+	float radiusSqr = aRadius * aRadius;
+	int minX = GetCell(aPosition.x - aRadius);
+	int minY = GetCell(aPosition.y - aRadius);
+	int minZ = GetCell(aPosition.z - aRadius);
+	int maxX = GetCell(aPosition.x + aRadius);
+	int maxY = GetCell(aPosition.y + aRadius);
+	int maxZ = GetCell(aPosition.z + aRadius);
+
+	size_t cellCount = static_cast<size_t>(maxX - minX + 1) * static_cast<size_t>(maxY - minY + 1) * static_cast<size_t>(maxZ - minZ + 1);
+	if (cellCount > maxQueryCells)
+	{
+		for (const Entry& entry : myEntries)
+		{
+			float distanceSqr = (entry.target.position - aPosition).LengthSqr();
+			if (entry.isUsed && distanceSqr <= radiusSqr)
+				aVisit(entry, distanceSqr);
+		}
+		return;
+	}
+
+	for (int z = minZ; z <= maxZ; z++)
+	{
+		for (int y = minY; y <= maxY; y++)
+		{
+			for (int x = minX; x <= maxX; x++)
+			{
+				// Other cells hash to the same bucket too, they are skipped so no target is visited twice
+				for (Handle i = myBuckets[GetBucket(x, y, z)]; i != invalidHandle; i = myEntries[i].next)
+				{
+					const Entry& entry = myEntries[i];
+					if (entry.cellX != x || entry.cellY != y || entry.cellZ != z)
+						continue;
+
+					float distanceSqr = (entry.target.position - aPosition).LengthSqr();
+					if (distanceSqr <= radiusSqr)
+						aVisit(entry, distanceSqr);
+				}
+			}
+		}
+	}
+}
+
+int CompanionTargetGrid::GetCell(float aCoordinate) const
+{
+	return static_cast<int>(std::floor(aCoordinate * myInverseCellSize));
+}
+
+size_t CompanionTargetGrid::GetBucket(int anX, int aY, int aZ) const
+{
+	uint32_t hash = static_cast<uint32_t>(anX) * 73856093u ^ static_cast<uint32_t>(aY) * 19349663u ^ static_cast<uint32_t>(aZ) * 83492791u;
+	return hash & (myBuckets.size() - 1);
+}
+
+void CompanionTargetGrid::Link(Handle aHandle)
+{
+	Entry& entry = myEntries[aHandle];
+	Handle& head = myBuckets[GetBucket(entry.cellX, entry.cellY, entry.cellZ)];
+	entry.previous = invalidHandle;
+	entry.next = head;
+	if (head != invalidHandle)
+		myEntries[head].previous = aHandle;
+	head = aHandle;
+}
+
+void CompanionTargetGrid::Unlink(Handle aHandle)
+{
+	Entry& entry = myEntries[aHandle];
+	if (entry.previous != invalidHandle)
+		myEntries[entry.previous].next = entry.next;
+	else
+		myBuckets[GetBucket(entry.cellX, entry.cellY, entry.cellZ)] = entry.next;
+
+	if (entry.next != invalidHandle)
+		myEntries[entry.next].previous = entry.previous;
+}
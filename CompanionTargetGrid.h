@@ -0,0 +1,86 @@
+#pragma once
+#include <DreamEngine/math/Transform.h>
+#include <DreamEngine/math/Vector3.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class FlyingEnemy;
+class GroundEnemy;
+
+// Live enemies bucketed by position, so targeting looks at the enemies around a companion instead of every
+// enemy in the pools. Space is cut into cubic cells hashed into a fixed number of buckets, an enemy is only
+// rebucketed when it crosses into another cell, and nothing is allocated once the entries have grown to the
+// number of enemies. Queries only read, so any number of companions or turrets may run them at once as
+// long as nothing updates the grid meanwhile.
+class CompanionTargetGrid
+{
+public:
+	using Handle = uint32_t;
+	static constexpr Handle invalidHandle = ~0u;
+
+	struct Target
+	{
+		const DE::Transform* transform;
+		DE::Vector3f position;
+	};
+
+	// aCellSize is best around the usual query radius, aBucketCount is rounded up to a power of two
+	CompanionTargetGrid(float aCellSize = 1000.0f, size_t aBucketCount = 4096);
+
+	Handle Add(const DE::Transform& aTransform);
+	// Takes the position from the transform given to Add again
+	void Move(Handle aHandle);
+	void Remove(Handle aHandle);
+	void Clear();
+
+	// Brings the grid in line with the enemy pools: enemies that came alive are added, the ones still alive
+	// moved and the dead ones removed. Each list keeps the handles of its enemies by index, so call this with
+	// the same lists every frame.
+	void Sync(const std::vector<std::shared_ptr<FlyingEnemy>>& someFlyingEnemies, const std::vector<std::shared_ptr<GroundEnemy>>& someGroundEnemies);
+
+	// Closest target within aRadius of aPosition, nullptr when there is none. Targets stay valid until the
+	// next Add or Sync.
+	const Target* FindNearest(const DE::Vector3f& aPosition, float aRadius) const;
+	// Up to aMaxCount closest targets within aRadius, closest first. Returns how many were found.
+	size_t FindNearest(const DE::Vector3f& aPosition, float aRadius, const Target** someTargets, size_t aMaxCount) const;
+	// The closest target to each of aCount positions, for doing all turrets at once
+	void FindNearest(const DE::Vector3f* somePositions, size_t aCount, float aRadius, const Target** someTargets) const;
+
+	size_t GetCount() const { return myCount; }
+
+private:
+	struct Entry
+	{
+		Target target;
+		int cellX;
+		int cellY;
+		int cellZ;
+		// Neighbours in the bucket's list, or in the free list for unused entries
+		Handle previous;
+		Handle next;
+		bool isUsed;
+	};
+
+	// Calls aVisit(entry) for every target within aRadius of aPosition, with its squared distance
+	template <class Visit>
+	void ForEachWithin(const DE::Vector3f& aPosition, float aRadius, Visit&& aVisit) const;
+	template <class Enemy>
+	void SyncList(const std::vector<std::shared_ptr<Enemy>>& someEnemies, std::vector<Handle>& someHandles);
+
+	int GetCell(float aCoordinate) const;
+	size_t GetBucket(int anX, int aY, int aZ) const;
+	void Link(Handle aHandle);
+	void Unlink(Handle aHandle);
+
+	float myCellSize;
+	float myInverseCellSize;
+	std::vector<Handle> myBuckets;
+	std::vector<Entry> myEntries;
+	Handle myFreeEntries = invalidHandle;
+	size_t myCount = 0;
+
+	std::vector<Handle> myFlyingHandles;
+	std::vector<Handle> myGroundHandles;
+};
@@ -1,85 +1,101 @@
 #pragma once
 #include "BehaviourTree.h" 
+#include "CompanionContext.h"
 
 class CompanionBehavior;
+class NodeTypeRegistry;
 
 class HaveNoOrder: public Selector
 {
 public:
-	HaveNoOrder(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	static constexpr uint32_t ourReadMask = CompanionField::Order;
+
+	static bool Condition(TickContext& aContext);
+	Status Update(TickContext& aContext) override;
 };
 
 class HaveOrder: public Selector
 {
 public:
-	HaveOrder(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	static constexpr uint32_t ourReadMask = CompanionField::Order;
+
+	static bool Condition(TickContext& aContext);
+	Status Update(TickContext& aContext) override;
 };
 
 class FollowPlayer: public Sequence
 {
 public:
-	FollowPlayer(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	static constexpr uint32_t ourReadMask = CompanionField::Order | CompanionField::PlayerPos;
+
+	Status Update(TickContext& aContext) override;
 };
 
 class Fetch: public Selector
 {
 public:
-	Fetch(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	static constexpr uint32_t ourReadMask = CompanionField::HasPickedUp;
+
+	Status Update(TickContext& aContext) override;
 };
 
 class Turret: public Sequence
 {
 public:
-	Turret(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	static constexpr uint32_t ourReadMask = CompanionField::TurretCooldown | CompanionField::TurretTimer;
+
+	Status Update(TickContext& aContext) override;
 };
 
 class PickUp: public Selector
 {
 public:
-	PickUp(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	static constexpr uint32_t ourReadMask = CompanionField::HealCooldown | CompanionField::HealingStation | CompanionField::Transform;
+
+	Status Update(TickContext& aContext) override;
 };
 
 class DropOff: public Selector
 {
 public:
-	DropOff(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	static constexpr uint32_t ourReadMask = CompanionField::PlayerPos | CompanionField::Transform;
+
+	Status Update(TickContext& aContext) override;
 };
 
 class ShootEnemy: public Leaf
 {
 public:
-	ShootEnemy(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	static constexpr uint32_t ourReadMask = CompanionField::ShootTimer | CompanionField::NoShooting | CompanionField::Enemy;
+
+	Status Update(TickContext& aContext) override;
 };
 
 class Intro: public Leaf
 {
 public:
-	Intro(CompanionBehavior* aCompanionBehavior): myController(aCompanionBehavior) {}
-	Status Update() override;
-private:
-	CompanionBehavior* myController;
+	// Transform is only read once the intro runs, Update adds it then
+	static constexpr uint32_t ourReadMask = CompanionField::Order | CompanionField::HasWokenUp;
+
+	Status Update(TickContext& aContext) override;
 };
+
+// The companion tree as a type, see StaticBehaviourTree. The nodes read their CompanionBehavior from the
+// tick context, so one definition serves every companion.
+using CompanionTree =
+	StaticSelector<
+		StaticComposite<HaveNoOrder,
+			Intro,
+			StaticComposite<FollowPlayer,
+				ShootEnemy>>,
+		StaticComposite<HaveOrder,
+			StaticComposite<Fetch,
+				PickUp,
+				DropOff>,
+			StaticComposite<Turret,
+				ShootEnemy>>>;
+
+using CompanionTreeDefinition = StaticBehaviourTree<CompanionTree>;
+
+// Registers Sequence, Selector and every companion node under its class name, for trees loaded from assets
+void RegisterCompanionNodes(NodeTypeRegistry& aRegistry);
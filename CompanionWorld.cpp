@@ -0,0 +1,128 @@
+#include "CompanionWorld.h"
+#include "MainSingleton.h"
+#include "ProjectilePool.h"
+
+#include <DreamEngine/windows/settings.h>
+#include <DreamEngine/graphics/TextureManager.h>
+#include <DreamEngine/graphics/ModelFactory.h>
+#include <PhysX/PxPhysicsAPI.h>
+#include <cstring>
+
+namespace
+{
+	class EngineCompanionWorld: public CompanionWorld
+	{
+	public:
+		bool Raycast(const DreamEngine::Vector3f& anOrigin, const DreamEngine::Vector3f& aDirection, float aLength, float& aHitDistance) override
+		{
+			RaycastQuery query = { anOrigin, aDirection, aLength };
+			RaycastResult result;
+			RaycastBatch(&query, &result, 1);
+
+			if (result.hit)
+				aHitDistance = result.distance;
+			return result.hit;
+		}
+
+		// The scene, filters and hit buffer are fetched once for the whole batch
+		void RaycastBatch(const RaycastQuery* someQueries, RaycastResult* someResults, size_t aCount) override
+		{
+			physx::PxScene* scene = MainSingleton::GetInstance()->GetPhysXScene();
+
+			auto collisionFiltering = MainSingleton::GetInstance()->GetCollisionFiltering();
+			physx::PxQueryFilterData queryFilterData;
+			queryFilterData.data.word0 = collisionFiltering.Environment;
+			physx::PxQueryFilterData dynamicFilterData = queryFilterData;
+			dynamicFilterData.flags = physx::PxQueryFlag::eDYNAMIC;
+
+			physx::PxRaycastBufferN<64> hitInfo;
+			for (size_t i = 0; i < aCount; i++)
+			{
+				const RaycastQuery& query = someQueries[i];
+				physx::PxVec3 origin = physx::PxVec3(query.origin.x, query.origin.y, query.origin.z);
+				physx::PxVec3 direction = physx::PxVec3(query.direction.x, query.direction.y, query.direction.z);
+
+				someResults[i] = { 0.0f, false };
+				if (!scene->raycast(origin, direction, query.length, hitInfo, physx::PxHitFlag::eDEFAULT, query.dynamicOnly ? dynamicFilterData : queryFilterData))
+					continue;
+
+				for (physx::PxU32 j = 0; j < hitInfo.nbTouches; ++j)
+				{
+					const physx::PxRaycastHit& hit = hitInfo.touches[j];
+					const char* name = hit.actor->getName();
+					if (name != nullptr && std::strcmp(name, "Companion") == 0) continue; // Ignore own body
+					someResults[i] = { hit.distance, true };
+					break;
+				}
+			}
+		}
+
+		void TriggerMessage(const Message& aMessage) override
+		{
+			MainSingleton::GetInstance()->GetPostMaster().TriggerMessage(aMessage);
+		}
+
+		void PlayAudio(eAudioEvent anEvent, const DreamEngine::Vector3f& aPosition) override
+		{
+			MainSingleton::GetInstance()->GetAudioManager().PlayAudio(anEvent, aPosition);
+		}
+
+		void StopAudio(eAudioEvent anEvent) override
+		{
+			MainSingleton::GetInstance()->GetAudioManager().StopAudio(anEvent);
+		}
+
+		DreamEngine::Transform GetCameraTransform() override
+		{
+			return MainSingleton::GetInstance()->GetActiveCamera()->GetTransform();
+		}
+
+		bool IsPaused() override
+		{
+			return MainSingleton::GetInstance()->GetGameToPause();
+		}
+
+		bool IsKeyDown(DreamEngine::eKeyCode aKey) override
+		{
+			return MainSingleton::GetInstance()->GetInputManager().IsKeyDown(aKey);
+		}
+
+		DreamEngine::Texture* LoadTexture(const wchar_t* anAssetPath, bool anIsColor) override
+		{
+			std::wstring path = DreamEngine::Settings::ResolveAssetPathW(anAssetPath);
+			return DreamEngine::Engine::GetInstance()->GetTextureManager().GetTexture(path.c_str(), anIsColor);
+		}
+
+		std::shared_ptr<DreamEngine::ModelInstance> LoadModelInstance(const wchar_t* anAssetPath) override
+		{
+			return std::make_shared<DreamEngine::ModelInstance>(DreamEngine::ModelFactory::GetInstance().GetModelInstance(anAssetPath));
+		}
+
+		ProjectilePool* CreateProjectilePool() override
+		{
+			return new ProjectilePool(1, false);
+		}
+	};
+
+	EngineCompanionWorld engineWorld;
+	CompanionWorld* currentWorld = &engineWorld;
+}
+
+void CompanionWorld::RaycastBatch(const RaycastQuery* someQueries, RaycastResult* someResults, size_t aCount)
+{
+	for (size_t i = 0; i < aCount; i++)
+	{
+		someResults[i].distance = 0.0f;
+		someResults[i].hit = Raycast(someQueries[i].origin, someQueries[i].direction, someQueries[i].length, someResults[i].distance);
+	}
+}
+
+CompanionWorld& CompanionWorld::Get()
+{
+	return *currentWorld;
+}
+
+void CompanionWorld::Set(CompanionWorld* aWorld)
+{
+	currentWorld = aWorld != nullptr ? aWorld : &engineWorld;
+}
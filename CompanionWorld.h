@@ -0,0 +1,75 @@
+#pragma once
+#include "Message.h"
+
+#include <DreamEngine/math/Vector.h>
+#include <DreamEngine/math/Transform.h>
+#include <memory>
+
+// Declared here rather than through MainSingleton.h, so a world can be built without the game singleton
+enum class eAudioEvent;
+namespace DreamEngine
+{
+	enum class eKeyCode;
+	class ModelInstance;
+	class Texture;
+}
+
+class CompanionDistanceField;
+class ProjectilePool;
+
+// Everything the companion AI asks of the game while it updates: environment raycasts, messages, audio,
+// the camera, the pause state and input, and the assets and pools CompanionBehavior sets up in Init. The game's MainSingleton and PhysX scene answer by default, a
+// different world can be set to run companions without them, see HeadlessCompanionWorld.
+class CompanionWorld
+{
+public:
+	struct RaycastQuery
+	{
+		DreamEngine::Vector3f origin;
+		DreamEngine::Vector3f direction;
+		float length;
+		// Only moving actors are hit, for when a CompanionDistanceField covers the static environment
+		bool dynamicOnly = false;
+	};
+
+	struct RaycastResult
+	{
+		float distance;
+		bool hit;
+	};
+
+	virtual ~CompanionWorld() = default;
+
+	// The world in use, the engine's unless one has been set
+	static CompanionWorld& Get();
+	// Replaces the world in use, nullptr goes back to the engine's. Set it before companions update.
+	static void Set(CompanionWorld* aWorld);
+
+	// Casts aLength along aDirection against the environment, ignoring companions. aHitDistance is the
+	// distance to the first hit.
+	virtual bool Raycast(const DreamEngine::Vector3f& anOrigin, const DreamEngine::Vector3f& aDirection, float aLength, float& aHitDistance) = 0;
+	// Raycast for every query, may be called from several threads at once for different ranges
+	virtual void RaycastBatch(const RaycastQuery* someQueries, RaycastResult* someResults, size_t aCount);
+
+	virtual void TriggerMessage(const Message& aMessage) = 0;
+	virtual void PlayAudio(eAudioEvent anEvent, const DreamEngine::Vector3f& aPosition) = 0;
+	virtual void StopAudio(eAudioEvent anEvent) = 0;
+
+	virtual DreamEngine::Transform GetCameraTransform() = 0;
+	virtual bool IsPaused() = 0;
+	virtual bool IsKeyDown(DreamEngine::eKeyCode aKey) = 0;
+
+	// Setup, main thread only. Paths are relative to the asset folder. A world without a renderer returns
+	// nullptr and the companion runs without the model, textures or projectiles.
+	virtual DreamEngine::Texture* LoadTexture(const wchar_t* anAssetPath, bool anIsColor) = 0;
+	virtual std::shared_ptr<DreamEngine::ModelInstance> LoadModelInstance(const wchar_t* anAssetPath) = 0;
+	virtual ProjectilePool* CreateProjectilePool() = 0;
+
+	// Baked distances to the static environment, avoidance samples it instead of raycasting against static
+	// geometry while one is set. The field is not owned and has to outlive its use.
+	void SetDistanceField(const CompanionDistanceField* aField) { myDistanceField = aField; }
+	const CompanionDistanceField* GetDistanceField() const { return myDistanceField; }
+
+private:
+	const CompanionDistanceField* myDistanceField = nullptr;
+};
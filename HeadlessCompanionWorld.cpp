@@ -0,0 +1,196 @@
+#include "HeadlessCompanionWorld.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	// Distance along the ray to the sphere surface, negative on a miss. A ray starting inside hits at 0.
+	float RaySphere(const DreamEngine::Vector3f& anOrigin, const DreamEngine::Vector3f& aDirection, const DreamEngine::Vector3f& aCenter, float aRadius)
+	{
+		DreamEngine::Vector3f toOrigin = anOrigin - aCenter;
+		float b = toOrigin.Dot(aDirection);
+		float c = toOrigin.Dot(toOrigin) - aRadius * aRadius;
+		if (c <= 0.0f)
+			return 0.0f;
+
+		float discriminant = b * b - c;
+		if (b > 0.0f || discriminant < 0.0f)
+			return -1.0f;
+
+		return -b - std::sqrt(discriminant);
+	}
+
+	// Slab test, same conventions as RaySphere
+	float RayBox(const DreamEngine::Vector3f& anOrigin, const DreamEngine::Vector3f& aDirection, const DreamEngine::Vector3f& aMin, const DreamEngine::Vector3f& aMax)
+	{
+		float enter = 0.0f;
+		float exit = std::numeric_limits<float>::max();
+
+		const float origin[3] = { anOrigin.x, anOrigin.y, anOrigin.z };
+		const float direction[3] = { aDirection.x, aDirection.y, aDirection.z };
+		const float min[3] = { aMin.x, aMin.y, aMin.z };
+		const float max[3] = { aMax.x, aMax.y, aMax.z };
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (direction[axis] == 0.0f)
+			{
+				if (origin[axis] < min[axis] || origin[axis] > max[axis])
+					return -1.0f;
+				continue;
+			}
+
+			float first = (min[axis] - origin[axis]) / direction[axis];
+			float second = (max[axis] - origin[axis]) / direction[axis];
+			enter = std::max(enter, std::min(first, second));
+			exit = std::min(exit, std::max(first, second));
+			if (enter > exit)
+				return -1.0f;
+		}
+		return enter;
+	}
+}
+
+void HeadlessCompanionWorld::AddSphere(const DreamEngine::Vector3f& aCenter, float aRadius)
+{
+	mySpheres.push_back({ aCenter, aRadius });
+}
+
+void HeadlessCompanionWorld::AddBox(const DreamEngine::Vector3f& aMin, const DreamEngine::Vector3f& aMax)
+{
+	myBoxes.push_back({ aMin, aMax });
+}
+
+float HeadlessCompanionWorld::GetStaticDistance(const DreamEngine::Vector3f& aPosition) const
+{
+	float closest = std::numeric_limits<float>::max();
+	if (myHasGround)
+		closest = aPosition.y - myGroundHeight;
+
+	for (const Sphere& sphere : mySpheres)
+		closest = std::min(closest, (aPosition - sphere.center).Length() - sphere.radius);
+
+	for (const Box& box : myBoxes)
+	{
+		DreamEngine::Vector3f halfSize = (box.max - box.min) * 0.5f;
+		DreamEngine::Vector3f offset = aPosition - (box.min + halfSize);
+		DreamEngine::Vector3f outside(std::abs(offset.x) - halfSize.x, std::abs(offset.y) - halfSize.y, std::abs(offset.z) - halfSize.z);
+
+		float inside = std::min(std::max({ outside.x, outside.y, outside.z }), 0.0f);
+		outside = DreamEngine::Vector3f(std::max(outside.x, 0.0f), std::max(outside.y, 0.0f), std::max(outside.z, 0.0f));
+		closest = std::min(closest, outside.Length() + inside);
+	}
+	return closest;
+}
+
+void HeadlessCompanionWorld::SetPlayerPath(const std::vector<DreamEngine::Vector3f>& someWaypoints, float aSpeed)
+{
+	myPlayerPath = someWaypoints;
+	myPlayerSpeed = aSpeed;
+	myNextWaypoint = 0;
+	if (!myPlayerPath.empty())
+		myPlayerPosition = myPlayerPath.front();
+}
+
+void HeadlessCompanionWorld::SetKeyDown(DreamEngine::eKeyCode aKey, bool anIsDown)
+{
+	auto key = std::find(myKeysDown.begin(), myKeysDown.end(), aKey);
+	if (anIsDown && key == myKeysDown.end())
+		myKeysDown.push_back(aKey);
+	else if (!anIsDown && key != myKeysDown.end())
+		myKeysDown.erase(key);
+}
+
+void HeadlessCompanionWorld::Advance(float aDeltaTime)
+{
+	if (myPlayerPath.size() < 2)
+		return;
+
+	float distance = myPlayerSpeed * aDeltaTime;
+	while (distance > 0.0f)
+	{
+		DreamEngine::Vector3f toWaypoint = myPlayerPath[myNextWaypoint] - myPlayerPosition;
+		float length = toWaypoint.Length();
+		if (length > distance)
+		{
+			myPlayerPosition += toWaypoint * (distance / length);
+			return;
+		}
+
+		myPlayerPosition = myPlayerPath[myNextWaypoint];
+		myNextWaypoint = (myNextWaypoint + 1) % myPlayerPath.size();
+		distance -= length;
+	}
+}
+
+void HeadlessCompanionWorld::ClearRecordings()
+{
+	myMessages.clear();
+	myAudio.clear();
+	myRaycastCount.store(0);
+}
+
+bool HeadlessCompanionWorld::Raycast(const DreamEngine::Vector3f& anOrigin, const DreamEngine::Vector3f& aDirection, float aLength, float& aHitDistance)
+{
+	myRaycastCount.fetch_add(1, std::memory_order_relaxed);
+
+	DreamEngine::Vector3f direction = aDirection.GetNormalized();
+	float closest = aLength;
+	bool hit = false;
+
+	auto consider = [&closest, &hit](float aDistance)
+		{
+			if (aDistance >= 0.0f && aDistance <= closest)
+			{
+				closest = aDistance;
+				hit = true;
+			}
+		};
+
+	for (const Sphere& sphere : mySpheres)
+		consider(RaySphere(anOrigin, direction, sphere.center, sphere.radius));
+	for (const Box& box : myBoxes)
+		consider(RayBox(anOrigin, direction, box.min, box.max));
+
+	if (myHasGround && direction.y != 0.0f)
+		consider((myGroundHeight - anOrigin.y) / direction.y);
+
+	if (hit)
+		aHitDistance = closest;
+	return hit;
+}
+
+void HeadlessCompanionWorld::RaycastBatch(const RaycastQuery* someQueries, RaycastResult* someResults, size_t aCount)
+{
+	for (size_t i = 0; i < aCount; i++)
+	{
+		someResults[i] = { 0.0f, false };
+		if (!someQueries[i].dynamicOnly)
+			someResults[i].hit = Raycast(someQueries[i].origin, someQueries[i].direction, someQueries[i].length, someResults[i].distance);
+	}
+}
+
+void HeadlessCompanionWorld::TriggerMessage(const Message& aMessage)
+{
+	// Companion messages carry a bool when they carry anything
+	bool hasValue = aMessage.messageData != nullptr;
+	myMessages.push_back({ aMessage.messageType, hasValue, hasValue && *static_cast<const bool*>(aMessage.messageData) });
+}
+
+void HeadlessCompanionWorld::PlayAudio(eAudioEvent anEvent, const DreamEngine::Vector3f& aPosition)
+{
+	myAudio.push_back({ anEvent, aPosition, false });
+}
+
+void HeadlessCompanionWorld::StopAudio(eAudioEvent anEvent)
+{
+	myAudio.push_back({ anEvent, DreamEngine::Vector3f(), true });
+}
+
+bool HeadlessCompanionWorld::IsKeyDown(DreamEngine::eKeyCode aKey)
+{
+	return std::find(myKeysDown.begin(), myKeysDown.end(), aKey) != myKeysDown.end();
+}
+
@@ -0,0 +1,97 @@
+#pragma once
+#include "CompanionWorld.h"
+
+#include <atomic>
+#include <vector>
+
+// Stand-in world for running companions without the game, for profiling and regression runs. The
+// environment is a set of static spheres and boxes with an optional ground plane, messages and audio are
+// recorded instead of sent, and a scripted player walks a looping path. Set it with CompanionWorld::Set
+// and call Advance once per simulated frame.
+class HeadlessCompanionWorld: public CompanionWorld
+{
+public:
+	struct RecordedMessage
+	{
+		eMessageType type;
+		bool hasValue;
+		bool value;
+	};
+
+	struct RecordedAudio
+	{
+		eAudioEvent event;
+		DreamEngine::Vector3f position;
+		bool isStop;
+	};
+
+	// Static geometry, boxes are axis aligned
+	void AddSphere(const DreamEngine::Vector3f& aCenter, float aRadius);
+	void AddBox(const DreamEngine::Vector3f& aMin, const DreamEngine::Vector3f& aMax);
+	void SetGroundHeight(float aHeight) { myGroundHeight = aHeight; myHasGround = true; }
+	// Signed distance to the closest piece of geometry, negative inside. Bake a CompanionDistanceField from it
+	// to avoid the scene without raycasts.
+	float GetStaticDistance(const DreamEngine::Vector3f& aPosition) const;
+
+	// The player walks the waypoints in order at aSpeed units per second and starts over after the last
+	void SetPlayerPath(const std::vector<DreamEngine::Vector3f>& someWaypoints, float aSpeed);
+	const DreamEngine::Vector3f& GetPlayerPosition() const { return myPlayerPosition; }
+
+	void SetCameraTransform(const DreamEngine::Transform& aTransform) { myCameraTransform = aTransform; }
+	void SetPaused(bool anIsPaused) { myIsPaused = anIsPaused; }
+	void SetKeyDown(DreamEngine::eKeyCode aKey, bool anIsDown);
+
+	// Moves the player along its path
+	void Advance(float aDeltaTime);
+
+	const std::vector<RecordedMessage>& GetMessages() const { return myMessages; }
+	const std::vector<RecordedAudio>& GetAudio() const { return myAudio; }
+	// Raycasts that were tested against the geometry, dynamic only ones never are as all of it is static
+	size_t GetRaycastCount() const { return myRaycastCount.load(); }
+	void ClearRecordings();
+
+	// Safe to call from several threads, the geometry is only read
+	bool Raycast(const DreamEngine::Vector3f& anOrigin, const DreamEngine::Vector3f& aDirection, float aLength, float& aHitDistance) override;
+	void RaycastBatch(const RaycastQuery* someQueries, RaycastResult* someResults, size_t aCount) override;
+	void TriggerMessage(const Message& aMessage) override;
+	void PlayAudio(eAudioEvent anEvent, const DreamEngine::Vector3f& aPosition) override;
+	void StopAudio(eAudioEvent anEvent) override;
+	DreamEngine::Transform GetCameraTransform() override { return myCameraTransform; }
+	bool IsPaused() override { return myIsPaused; }
+	bool IsKeyDown(DreamEngine::eKeyCode aKey) override;
+	// Nothing is rendered or shot, so there is nothing to load
+	DreamEngine::Texture* LoadTexture(const wchar_t*, bool) override { return nullptr; }
+	std::shared_ptr<DreamEngine::ModelInstance> LoadModelInstance(const wchar_t*) override { return nullptr; }
+	ProjectilePool* CreateProjectilePool() override { return nullptr; }
+
+private:
+	struct Sphere
+	{
+		DreamEngine::Vector3f center;
+		float radius;
+	};
+
+	struct Box
+	{
+		DreamEngine::Vector3f min;
+		DreamEngine::Vector3f max;
+	};
+
+	std::vector<Sphere> mySpheres;
+	std::vector<Box> myBoxes;
+	float myGroundHeight = 0.0f;
+	bool myHasGround = false;
+
+	std::vector<DreamEngine::Vector3f> myPlayerPath;
+	DreamEngine::Vector3f myPlayerPosition;
+	size_t myNextWaypoint = 0;
+	float myPlayerSpeed = 0.0f;
+
+	DreamEngine::Transform myCameraTransform;
+	std::vector<DreamEngine::eKeyCode> myKeysDown;
+	bool myIsPaused = false;
+
+	std::vector<RecordedMessage> myMessages;
+	std::vector<RecordedAudio> myAudio;
+	std::atomic<size_t> myRaycastCount = 0;
+};
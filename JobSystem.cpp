@@ -0,0 +1,147 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(): JobSystem(std::max(1u, std::thread::hardware_concurrency()) - 1)
+{}
+
+JobSystem::JobSystem(size_t aWorkerCount)
+{
+	for (size_t i = 0; i < aWorkerCount + 1; i++)
+		myQueues.push_back(std::make_unique<JobQueue>());
+
+	for (size_t i = 0; i < aWorkerCount; i++)
+		myWorkers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(myWakeMutex);
+		myIsRunning = false;
+	}
+	myWakeCondition.notify_all();
+
+	for (std::thread& worker : myWorkers)
+		worker.join();
+}
+
+void JobSystem::ParallelFor(size_t aCount, size_t aGrainSize, const std::function<void(size_t, size_t)>& aFunction)
+{
+	if (aCount == 0)
+		return;
+
+	aGrainSize = std::max<size_t>(aGrainSize, 1);
+	if (myWorkers.empty() || aCount <= aGrainSize)
+	{
+		aFunction(0, aCount);
+		return;
+	}
+
+	size_t jobCount = (aCount + aGrainSize - 1) / aGrainSize;
+	std::atomic<size_t> remaining = jobCount;
+
+	for (size_t i = 0; i < jobCount; i++)
+	{
+		Job job = { &aFunction, i * aGrainSize, std::min(aCount, (i + 1) * aGrainSize), &remaining };
+
+		JobQueue& queue = *myQueues[i % myQueues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.PushBack(job);
+	}
+
+	// Taking the wake mutex makes sure no worker is between checking for work and going to sleep
+	{
+		std::lock_guard<std::mutex> lock(myWakeMutex);
+		myQueuedJobs += jobCount;
+	}
+	myWakeCondition.notify_all();
+
+	Job job;
+	while (remaining.load(std::memory_order_acquire) > 0)
+	{
+		if (PopOrSteal(0, job))
+			Run(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::WorkerLoop(size_t aQueueIndex)
+{
+	Job job;
+	while (myIsRunning)
+	{
+		if (PopOrSteal(aQueueIndex, job))
+		{
+			Run(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(myWakeMutex);
+		myWakeCondition.wait(lock, [this]() { return !myIsRunning || myQueuedJobs > 0; });
+	}
+}
+
+bool JobSystem::PopOrSteal(size_t aQueueIndex, Job& aJob)
+{
+	{
+		JobQueue& ownQueue = *myQueues[aQueueIndex];
+		std::lock_guard<std::mutex> lock(ownQueue.mutex);
+		if (ownQueue.count > 0)
+		{
+			aJob = ownQueue.PopBack();
+			myQueuedJobs--;
+			return true;
+		}
+	}
+
+	for (size_t i = 1; i < myQueues.size(); i++)
+	{
+		JobQueue& victim = *myQueues[(aQueueIndex + i) % myQueues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.count > 0)
+		{
+			aJob = victim.PopFront();
+			myQueuedJobs--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Run(const Job& aJob)
+{
+	(*aJob.function)(aJob.first, aJob.last);
+	aJob.remaining->fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::JobQueue::PushBack(const Job& aJob)
+{
+	if (count == jobs.size())
+	{
+		// Unwraps the jobs into the front of the bigger buffer
+		std::vector<Job> grown(std::max<size_t>(16, jobs.size() * 2));
+		for (size_t i = 0; i < count; i++)
+			grown[i] = jobs[(front + i) % jobs.size()];
+		jobs.swap(grown);
+		front = 0;
+	}
+
+	jobs[(front + count) % jobs.size()] = aJob;
+	count++;
+}
+
+JobSystem::Job JobSystem::JobQueue::PopBack()
+{
+	count--;
+	return jobs[(front + count) % jobs.size()];
+}
+
+JobSystem::Job JobSystem::JobQueue::PopFront()
+{
+	Job job = jobs[front];
+	front = (front + 1) % jobs.size();
+	count--;
+	return job;
+}
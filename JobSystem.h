@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing job system. Every worker owns a queue it takes work from the back of, and steals from
+// the front of the other queues when its own runs dry. The thread calling ParallelFor works as well until
+// the whole range is done, so each call acts as a barrier.
+class JobSystem
+{
+public:
+	JobSystem();
+	JobSystem(size_t aWorkerCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Runs aFunction(first, last) over [0, aCount) in chunks of at most aGrainSize and returns when all chunks are done
+	void ParallelFor(size_t aCount, size_t aGrainSize, const std::function<void(size_t, size_t)>& aFunction);
+
+	size_t GetWorkerCount() const { return myWorkers.size(); }
+
+private:
+	struct Job
+	{
+		const std::function<void(size_t, size_t)>* function;
+		size_t first;
+		size_t last;
+		std::atomic<size_t>* remaining;
+	};
+
+	// A ring buffer rather than a deque, which allocates and frees blocks as jobs pass through it. It only
+	// grows when full, so once it has held a frame's jobs it never allocates again.
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::vector<Job> jobs;
+		size_t front = 0;
+		size_t count = 0;
+
+		void PushBack(const Job& aJob);
+		Job PopBack();
+		Job PopFront();
+	};
+
+	void WorkerLoop(size_t aQueueIndex);
+	bool PopOrSteal(size_t aQueueIndex, Job& aJob);
+	void Run(const Job& aJob);
+
+	// Queue 0 belongs to the thread calling ParallelFor, the rest to the workers
+	std::vector<std::unique_ptr<JobQueue>> myQueues;
+	std::vector<std::thread> myWorkers;
+
+	std::mutex myWakeMutex;
+	std::condition_variable myWakeCondition;
+	std::atomic<size_t> myQueuedJobs = 0;
+	std::atomic<bool> myIsRunning = true;
+};
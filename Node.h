@@ -1,10 +1,19 @@
 #pragma once
 #include <memory>
+#include <cstdint>
+#include <assert.h>
+
+#ifdef BEHAVIOUR_TREE_PROFILING
+#include "BehaviourTreeProfiler.h"
+#include <typeinfo>
+#endif
+
+class TickContext;
 
 class Node
 {
 public:
-    enum class Status
+    enum class Status: uint8_t
     {
         Invalid,
         Success,
@@ -12,34 +21,115 @@ public:
         Running,
     };
     virtual ~Node() = default;
-    virtual Status Update() = 0;
-    virtual void Init() {}
-    virtual void Terminate(Status aStatus) { aStatus; }
+    virtual Status Update(TickContext& aContext) = 0;
+    virtual void Init(TickContext& aContext) { aContext; }
+    virtual void Terminate(TickContext& aContext, Status aStatus) { aContext; aStatus; }
 
-    bool CheckStatus(Status aStatus) { return myStatus == aStatus; }
+    uint16_t GetIndex() const { return myIndex; }
+    void SetIndex(uint16_t anIndex) { myIndex = anIndex; }
 
-    void reset() { myStatus = Status::Invalid; }
+    Status Tick(TickContext& aContext);
 
-    Status Tick()
-    {
-        if(myStatus != Status::Running)
-        {
-            Init();
-        }
+    // Same as Tick() but with the concrete node type known, so every call is resolved at compile time
+    template <class NodeType>
+    static Status TickStatic(NodeType& aNode, TickContext& aContext);
+
+    std::shared_ptr<Node> myChild;
+
+protected:
+    // Slot of this node in the per-agent BehaviourTreeState, assigned by the tree the node is built into
+    uint16_t myIndex = 0;
+};
+
+// Everything a tree writes while ticking, one block per agent. Nodes hold no per-agent data
+// so a single built tree can be ticked for any number of agents.
+template <size_t NodeCount>
+struct BehaviourTreeState
+{
+    Node::Status statuses[NodeCount];
+    uint16_t cursors[NodeCount];
+    uint32_t activeReadMask;
+};
 
-        myStatus = Update();
+class TickContext
+{
+public:
+    template <size_t NodeCount>
+    TickContext(BehaviourTreeState<NodeCount>& aState, void* anAgent):
+        myStatuses(aState.statuses), myCursors(aState.cursors), myNodeCount(NodeCount), myAgent(anAgent) {}
 
-        if(myStatus != Status::Running)
-        {
-            Terminate(myStatus);
-        }
+    template <class AgentType>
+    AgentType& GetAgent() const { return *static_cast<AgentType*>(myAgent); }
 
-        return myStatus;
+    Node::Status& GetStatus(uint16_t anIndex)
+    {
+        assert(anIndex < myNodeCount && "Tree state is too small for this tree");
+        return myStatuses[anIndex];
     }
+    uint16_t& GetCursor(uint16_t anIndex)
+    {
+        assert(anIndex < myNodeCount && "Tree state is too small for this tree");
+        return myCursors[anIndex];
+    }
+    size_t GetNodeCount() const { return myNodeCount; }
 
-    std::shared_ptr<Node> myChild;
+    void AddReadMask(uint32_t aReadMask) { myReadMask |= aReadMask; }
+    void ClearReadMask() { myReadMask = 0; }
+    uint32_t GetReadMask() const { return myReadMask; }
 
-protected:
-    Status myStatus = Status::Invalid;
+private:
+    Node::Status* myStatuses;
+    uint16_t* myCursors;
+    size_t myNodeCount;
+    void* myAgent;
+    uint32_t myReadMask = 0;
 };
 
+inline Node::Status Node::Tick(TickContext& aContext)
+{
+#ifdef BEHAVIOUR_TREE_PROFILING
+    BehaviourTreeProfiler::Scope profile(typeid(*this).name());
+#endif
+    Status& status = aContext.GetStatus(myIndex);
+    if(status != Status::Running)
+    {
+        Init(aContext);
+    }
+
+    status = Update(aContext);
+
+    if(status != Status::Running)
+    {
+        Terminate(aContext, status);
+    }
+
+#ifdef BEHAVIOUR_TREE_PROFILING
+    profile.SetStatus(static_cast<uint8_t>(status));
+#endif
+    return status;
+}
+
+template <class NodeType>
+Node::Status Node::TickStatic(NodeType& aNode, TickContext& aContext)
+{
+#ifdef BEHAVIOUR_TREE_PROFILING
+    BehaviourTreeProfiler::Scope profile(typeid(NodeType).name());
+#endif
+    Status& status = aContext.GetStatus(static_cast<Node&>(aNode).myIndex);
+    if(status != Status::Running)
+    {
+        aNode.NodeType::Init(aContext);
+    }
+
+    status = aNode.NodeType::Update(aContext);
+
+    if(status != Status::Running)
+    {
+        aNode.NodeType::Terminate(aContext, status);
+    }
+
+#ifdef BEHAVIOUR_TREE_PROFILING
+    profile.SetStatus(static_cast<uint8_t>(status));
+#endif
+    return status;
+}
@@ -0,0 +1,225 @@
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+
+namespace
+{
+	constexpr uint32_t slotMask = TimerWheel::ourSlotCount - 1;
+	constexpr uint64_t maxTicks = (1ull << (TimerWheel::ourSlotBits * TimerWheel::ourLevelCount)) - 1;
+}
+
+TimerWheel::TimerWheel()
+{
+	myBuckets.fill(ourNone);
+}
+
+TimerHandle TimerWheel::Create(float aDuration, Callback aCallback, void* anOwner, uint32_t aUserData)
+{
+	uint32_t index = myFirstFree;
+	if (index != ourNone)
+	{
+		myFirstFree = myTimers[index].next;
+	}
+	else
+	{
+		assert(myTimers.size() < (1u << 24) - 1 && "Too many timers");
+		index = static_cast<uint32_t>(myTimers.size());
+		myTimers.push_back({});
+		myTimers[index].generation = 1;
+	}
+
+	Timer& timer = myTimers[index];
+	timer.callback = aCallback;
+	timer.owner = anOwner;
+	timer.duration = aDuration;
+	timer.userData = aUserData;
+	timer.bucket = ourNoBucket;
+	timer.state = State::Expired;
+	Schedule(index, aDuration);
+
+	return { (index + 1) | (static_cast<uint32_t>(timer.generation) << 24) };
+}
+
+void TimerWheel::Destroy(TimerHandle& aTimer)
+{
+	uint32_t index = GetSlot(aTimer);
+	Timer& timer = myTimers[index];
+	if (timer.bucket != ourNoBucket)
+		Unlink(index);
+
+	// Generation 0 is never handed out, so a handle of 0 can't match a reused slot
+	timer.generation = timer.generation == 0xff ? 1 : timer.generation + 1;
+	timer.state = State::Free;
+	timer.next = myFirstFree;
+	myFirstFree = index;
+	aTimer = {};
+}
+
+void TimerWheel::Restart(TimerHandle aTimer)
+{
+	uint32_t index = GetSlot(aTimer);
+	Schedule(index, myTimers[index].duration);
+}
+
+void TimerWheel::Start(TimerHandle aTimer, float aTime)
+{
+	Schedule(GetSlot(aTimer), aTime);
+}
+
+bool TimerWheel::IsExpired(TimerHandle aTimer) const
+{
+	return myTimers[GetSlot(aTimer)].state == State::Expired;
+}
+
+float TimerWheel::GetRemaining(TimerHandle aTimer) const
+{
+	const Timer& timer = myTimers[GetSlot(aTimer)];
+	if (timer.state == State::Expired)
+		return 0.0f;
+
+	return static_cast<float>(timer.deadline + 1 - myTick) * ourTickLength - myAccumulatedTime;
+}
+
+void TimerWheel::MoveTo(TimerHandle& aTimer, TimerWheel& aWheel)
+{
+	if (&aWheel == this)
+		return;
+
+	const Timer& timer = myTimers[GetSlot(aTimer)];
+	TimerHandle moved = aWheel.Create(timer.duration, timer.callback, timer.owner, timer.userData);
+	aWheel.Start(moved, GetRemaining(aTimer));
+
+	Destroy(aTimer);
+	aTimer = moved;
+}
+
+void TimerWheel::Advance(float aDeltaTime)
+{
+	myAccumulatedTime += aDeltaTime;
+	while (myAccumulatedTime >= ourTickLength)
+	{
+		myAccumulatedTime -= ourTickLength;
+		Step();
+	}
+}
+
+uint32_t TimerWheel::GetSlot(TimerHandle aTimer) const
+{
+	assert(aTimer.IsValid() && "No timer");
+
+	uint32_t index = (aTimer.id & 0xffffff) - 1;
+	assert(index < myTimers.size() && myTimers[index].generation == (aTimer.id >> 24) && "Stale timer handle");
+	return index;
+}
+
+void TimerWheel::Schedule(uint32_t anIndex, float aTime)
+{
+	Timer& timer = myTimers[anIndex];
+	if (timer.bucket != ourNoBucket)
+		Unlink(anIndex);
+
+	if (aTime <= 0.0f)
+	{
+		timer.state = State::Expired;
+		timer.callback(timer.owner, timer.userData);
+		return;
+	}
+
+	// Expires on the first tick that ends at least aTime from now, the part of a tick already passed counts
+	uint64_t ticks = static_cast<uint64_t>(std::ceil((myAccumulatedTime + aTime) / ourTickLength));
+	ticks = std::clamp<uint64_t>(ticks, 1, maxTicks);
+
+	timer.deadline = myTick + ticks - 1;
+	timer.state = State::Pending;
+	Insert(anIndex);
+}
+
+void TimerWheel::Insert(uint32_t anIndex)
+{
+	uint64_t deadline = myTimers[anIndex].deadline;
+	uint64_t ticksLeft = deadline - myTick;
+
+	int level = 0;
+	while (level < ourLevelCount - 1 && ticksLeft >= (1ull << (ourSlotBits * (level + 1))))
+		level++;
+
+	uint32_t slot = static_cast<uint32_t>(deadline >> (ourSlotBits * level)) & slotMask;
+	Link(anIndex, static_cast<uint16_t>(level * ourSlotCount + slot));
+}
+
+void TimerWheel::Link(uint32_t anIndex, uint16_t aBucket)
+{
+	Timer& timer = myTimers[anIndex];
+	timer.bucket = aBucket;
+	timer.prev = ourNone;
+	timer.next = myBuckets[aBucket];
+
+	if (timer.next != ourNone)
+		myTimers[timer.next].prev = anIndex;
+	myBuckets[aBucket] = anIndex;
+}
+
+void TimerWheel::Unlink(uint32_t anIndex)
+{
+	Timer& timer = myTimers[anIndex];
+
+	if (timer.prev != ourNone)
+		myTimers[timer.prev].next = timer.next;
+	else
+		myBuckets[timer.bucket] = timer.next;
+
+	if (timer.next != ourNone)
+		myTimers[timer.next].prev = timer.prev;
+
+	timer.bucket = ourNoBucket;
+}
+
+// Moves the timers of one bucket a level down, returns aSlot so the caller knows whether the next level wrapped too
+uint32_t TimerWheel::Cascade(int aLevel, uint32_t aSlot)
+{
+	uint16_t bucket = static_cast<uint16_t>(aLevel * ourSlotCount + aSlot);
+	uint32_t index = myBuckets[bucket];
+	myBuckets[bucket] = ourNone;
+
+	while (index != ourNone)
+	{
+		uint32_t next = myTimers[index].next;
+		Insert(index);
+		index = next;
+	}
+	return aSlot;
+}
+
+void TimerWheel::Step()
+{
+	uint32_t slot = static_cast<uint32_t>(myTick) & slotMask;
+	if (slot == 0)
+	{
+		for (int level = 1; level < ourLevelCount; level++)
+		{
+			if (Cascade(level, static_cast<uint32_t>(myTick >> (ourSlotBits * level)) & slotMask) != 0)
+				break;
+		}
+	}
+	myTick++;
+
+	// The bucket is moved to the firing list first, then timers are taken off it one by one since a
+	// callback may restart or destroy any of them
+	uint32_t index = myBuckets[slot];
+	myBuckets[slot] = ourNone;
+	myBuckets[ourFiringBucket] = index;
+	for (; index != ourNone; index = myTimers[index].next)
+		myTimers[index].bucket = ourFiringBucket;
+
+	while (myBuckets[ourFiringBucket] != ourNone)
+	{
+		index = myBuckets[ourFiringBucket];
+		Unlink(index);
+
+		Timer& timer = myTimers[index];
+		timer.state = State::Expired;
+		timer.callback(timer.owner, timer.userData);
+	}
+}
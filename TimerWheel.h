@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Identifies a timer in a TimerWheel. Handles to destroyed timers are recognised as stale.
+struct TimerHandle
+{
+	// Slot index + 1 in the low 24 bits, generation of the slot in the high 8, 0 is no timer
+	uint32_t id = 0;
+
+	bool IsValid() const { return id != 0; }
+};
+
+// Hierarchical timer wheel shared by any number of timers. Time advances in fixed ticks, and a timer sits in
+// the bucket of the tick it expires on, in a coarser level the further away that is. Timers are moved to a
+// finer level as their time comes closer, so a tick only touches the timers expiring on it and, every 64
+// ticks, the bucket cascading down. The cost of a tick does not depend on how many timers are waiting.
+// Expiring timers call their callback from Advance() and stay expired until restarted.
+class TimerWheel
+{
+public:
+	using Callback = void(*)(void* anOwner, uint32_t aUserData);
+
+	static constexpr float ourTickLength = 0.01f;
+	static constexpr int ourLevelCount = 4;
+	static constexpr int ourSlotBits = 6;
+	static constexpr uint32_t ourSlotCount = 1u << ourSlotBits;
+
+	TimerWheel();
+
+	// Starts a new timer running for aDuration seconds, aCallback(anOwner, aUserData) is called when it expires
+	TimerHandle Create(float aDuration, Callback aCallback, void* anOwner, uint32_t aUserData);
+	void Destroy(TimerHandle& aTimer);
+
+	// Runs the timer for its duration again, from now
+	void Restart(TimerHandle aTimer);
+	// Runs the timer for aTime seconds from now, expiring it right away if aTime is not positive
+	void Start(TimerHandle aTimer, float aTime);
+
+	bool IsExpired(TimerHandle aTimer) const;
+	float GetRemaining(TimerHandle aTimer) const;
+	float GetDuration(TimerHandle aTimer) const { return myTimers[GetSlot(aTimer)].duration; }
+	uint32_t GetUserData(TimerHandle aTimer) const { return myTimers[GetSlot(aTimer)].userData; }
+
+	// Moves the timer to aWheel with the time it has left, aTimer refers to the new timer afterwards
+	void MoveTo(TimerHandle& aTimer, TimerWheel& aWheel);
+
+	void Advance(float aDeltaTime);
+
+private:
+	enum class State: uint8_t { Free, Pending, Expired };
+
+	static constexpr uint32_t ourNone = ~0u;
+	static constexpr uint16_t ourNoBucket = 0xffff;
+	// The bucket being fired, kept apart so callbacks restarting timers don't add to it
+	static constexpr uint16_t ourFiringBucket = ourLevelCount * ourSlotCount;
+
+	struct Timer
+	{
+		Callback callback;
+		void* owner;
+		uint64_t deadline;
+		float duration;
+		uint32_t userData;
+		uint32_t next;
+		uint32_t prev;
+		uint16_t bucket;
+		uint8_t generation;
+		State state;
+	};
+
+	uint32_t GetSlot(TimerHandle aTimer) const;
+
+	void Schedule(uint32_t anIndex, float aTime);
+	void Insert(uint32_t anIndex);
+	void Link(uint32_t anIndex, uint16_t aBucket);
+	void Unlink(uint32_t anIndex);
+	uint32_t Cascade(int aLevel, uint32_t aSlot);
+	void Step();
+
+	std::vector<Timer> myTimers;
+	std::array<uint32_t, ourLevelCount * ourSlotCount + 1> myBuckets;
+	uint32_t myFirstFree = ourNone;
+
+	// The next tick to process, and the time since the last processed one
+	uint64_t myTick = 0;
+	float myAccumulatedTime = 0.0f;
+};